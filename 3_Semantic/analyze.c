@@ -6,143 +6,239 @@
 /* Kenneth C. Louden                                */
 /****************************************************/
 
+#include <limits.h>
+#include <pthread.h>
 #include "globals.h"
 #include "symtab.h"
 #include "analyze.h"
 #include "util.h"
+#include "intern.h"
+#include "arena.h"
+#include "compiler.h"
 
-/* counter for variable memory locations */
-static int location = 0;
-static ScopeList globalScope = NULL;
-static char *funcName;
-static int inScopeBefore = FALSE;
+/* ANALYZEMIN = the number of top-level declarations
+ * of the smallest program analyzed in parallel
+ */
+#define ANALYZEMIN 64
+
+/* a use of a global in a body analyzed in parallel,
+ * added to the line numbers of the global after
+ */
+typedef struct
+{
+  BucketList l;
+  int lineno;
+} GlobalUse;
 
-/* Procedure traverse is a generic recursive 
- * syntax tree traversal routine:
- * it applies preProc in preorder and postProc 
- * in postorder to tree pointed to by t
+/* the state of the analysis of a compilation */
+typedef struct AnalyzeRec
+{
+  ScopeList globalScope;
+  char *funcName;    /* function being analyzed */
+  int inScopeBefore; /* TRUE if the function declaration */
+                     /* opened the scope of its body      */
+  int fused;         /* TRUE in the single traversal */
+  TreeNode *tree;    /* of the single traversal */
+  /* a worker of a parallel analysis finds the
+   * globals declared already, but sees only the
+   * first visible of them, and keeps its uses of
+   * them in uses
+   */
+  int worker;
+  int visible;
+  GlobalUse *uses;
+  int useCount, useMax;
+} * Analyze;
+
+/* stateOf returns the analysis state of cc,
+ * creating it on first use
  */
-static void traverse(TreeNode *t,
-                     void (*preProc)(TreeNode *),
-                     void (*postProc)(TreeNode *))
+static Analyze stateOf(Compiler cc)
 {
-  if (t != NULL)
+  if (cc->analyze == NULL)
   {
-    preProc(t);
+    cc->analyze = (Analyze)calloc(1, sizeof(struct AnalyzeRec));
+    if (cc->analyze == NULL)
     {
-      int i;
-      for (i = 0; i < MAXCHILDREN; i++)
-        traverse(t->child[i], preProc, postProc);
+      fprintf(cc->listing, "Out of memory error at line %d\n", cc->lineno);
+      exit(1);
     }
-    postProc(t);
-    traverse(t->sibling, preProc, postProc);
+    cc->analyze->visible = INT_MAX;
   }
+  return cc->analyze;
+}
+
+/* Procedure analyzeFree releases the analysis
+ * state of cc
+ */
+void analyzeFree(Compiler cc)
+{
+  if (cc->analyze != NULL)
+    free(cc->analyze->uses);
+  free(cc->analyze);
+  cc->analyze = NULL;
 }
 
-static void typeError(TreeNode *t, char *message)
+/* lookup returns the symbol name as seen from the
+ * top scope, NULL if it is not visible there, and
+ * sets *scope to the scope that declares it
+ */
+static BucketList lookup(Compiler cc, char *name, ScopeList *scope)
 {
-  fprintf(listing, "Error: Type error at line %d: %s\n", t->lineno, message);
-  Error = TRUE;
+  Analyze a = stateOf(cc);
+  BucketList l = get_bucket_at(cc, name, scope);
+  if (l != NULL && *scope == a->globalScope && l->order >= a->visible)
+    return NULL;
+  return l;
 }
 
-static void symbolError(TreeNode *t, char *message)
+/* addUse adds line lineno to the uses of global l
+ * by a worker
+ */
+static void addUse(Compiler cc, BucketList l, int lineno)
 {
-  fprintf(listing, "Error: Symbol error at line %d: %s\n", t->lineno, message);
-  Error = TRUE;
+  Analyze a = stateOf(cc);
+  if (a->useCount == a->useMax)
+  {
+    a->useMax = a->useMax ? 2 * a->useMax : 256;
+    a->uses = (GlobalUse *)realloc(a->uses, a->useMax * sizeof(GlobalUse));
+    if (a->uses == NULL)
+    {
+      fprintf(cc->listing, "Out of memory error at line %d\n", lineno);
+      exit(1);
+    }
+  }
+  a->uses[a->useCount].l = l;
+  a->uses[a->useCount++].lineno = lineno;
 }
 
-static void undeclaredError(TreeNode *t)
+static void typeError(Compiler cc, TreeNode *t, char *message)
+{
+  fprintf(cc->listing, "Error: Type error at line %d: %s\n", t->lineno, message);
+  cc->Error = TRUE;
+}
+
+static void symbolError(Compiler cc, TreeNode *t, char *message)
+{
+  fprintf(cc->listing, "Error: Symbol error at line %d: %s\n", t->lineno, message);
+  cc->Error = TRUE;
+}
+
+static void undeclaredError(Compiler cc, TreeNode *t)
 {
   if (t->kind.exp == CallK)
-    fprintf(listing, "Error: Undeclared Function \"%s\" at line %d\n", t->attr.name, t->lineno);
+    fprintf(cc->listing, "Error: Undeclared Function \"%s\" at line %d\n", t->attr.name, t->lineno);
   else if (t->kind.exp == IdK || t->kind.exp == ArrIdK)
-    fprintf(listing, "Error: Undeclared Variable \"%s\" at line %d\n", t->attr.name, t->lineno);
-  Error = TRUE;
+    fprintf(cc->listing, "Error: Undeclared Variable \"%s\" at line %d\n", t->attr.name, t->lineno);
+  cc->Error = TRUE;
 }
 
-static void redefinedError(TreeNode *t)
+static void redefinedError(Compiler cc, TreeNode *t)
 {
   if (t->kind.decl == FuncK)
-    fprintf(listing, "Error: Redefined Function \"%s\" at line %d\n", t->attr.name, t->lineno);
+    fprintf(cc->listing, "Error: Redefined Function \"%s\" at line %d\n", t->attr.name, t->lineno);
   else if (t->kind.decl == VarK)
-    fprintf(listing, "Error: Redefined Variable \"%s\" at line %d\n", t->attr.name, t->lineno);
+    fprintf(cc->listing, "Error: Redefined Variable \"%s\" at line %d\n", t->attr.name, t->lineno);
   else if (t->kind.decl == ArrVarK)
-    fprintf(listing, "Error: Redefined Variable \"%s\" at line %d\n", t->attr.arr.name, t->lineno);
-  Error = TRUE;
+    fprintf(cc->listing, "Error: Redefined Variable \"%s\" at line %d\n", t->attr.arr.name, t->lineno);
+  cc->Error = TRUE;
 }
 
-static void funcDeclNotGlobal(TreeNode *t)
+static void funcDeclNotGlobal(Compiler cc, TreeNode *t)
 {
-  fprintf(listing, "Error: Function Definition is not allowed at line %d (name : %s)\n", t->lineno, t->attr.name);
-  Error = TRUE;
+  fprintf(cc->listing, "Error: Function Definition is not allowed at line %d (name : %s)\n", t->lineno, t->attr.name);
+  cc->Error = TRUE;
 }
 
-static void voidVarError(TreeNode *t, char *name)
+static void voidVarError(Compiler cc, TreeNode *t, char *name)
 {
-  fprintf(listing, "Error: Variable Type cannot be Void at line %d (name : %s)\n", t->lineno, name);
-  Error = TRUE;
+  fprintf(cc->listing, "Error: Variable Type cannot be Void at line %d (name : %s)\n", t->lineno, name);
+  cc->Error = TRUE;
 }
 
 /* input Function and output Function are
  * built-in Function, so there are global function
  * and have to print on Function Table 
 */
-static void insertIOFuncNode(void)
+static void insertIOFuncNode(Compiler cc)
 {
   TreeNode *func;
   TreeNode *typeSpec;
   TreeNode *param;
   TreeNode *compStmt;
 
-  func = newDeclNode(FuncK);
-  typeSpec = newTypeNode(FuncK);
+  func = newDeclNode(cc, FuncK);
+  typeSpec = newTypeNode(cc, TypeNameK);
   typeSpec->attr.type = INT;
   func->type = Integer;
 
-  compStmt = newStmtNode(CompK);
+  compStmt = newStmtNode(cc, CompK);
   compStmt->child[0] = NULL;
   compStmt->child[1] = NULL;
 
   func->lineno = 0;
-  func->attr.name = "input";
+  func->attr.name = intern(cc, "input");
   func->child[0] = typeSpec;
   func->child[1] = NULL;
   func->child[2] = compStmt;
 
-  st_insert("input", 0, addLocation(), func);
+  st_insert(cc, func->attr.name, 0, addLocation(cc, 1), func);
 
   /* output Function */
-  func = newDeclNode(FuncK);
+  func = newDeclNode(cc, FuncK);
 
-  typeSpec = newTypeNode(FuncK);
+  typeSpec = newTypeNode(cc, TypeNameK);
   typeSpec->attr.type = VOID;
   func->type = Void;
 
-  param = newParamNode(NonArrParamK);
-  param->attr.name = "arg";
+  param = newParamNode(cc, NonArrParamK);
+  param->attr.name = intern(cc, "arg");
   param->type = Integer;
-  param->child[0] = newTypeNode(FuncK);
+  param->child[0] = newTypeNode(cc, TypeNameK);
   param->child[0]->attr.type = INT;
 
-  compStmt = newStmtNode(CompK);
+  compStmt = newStmtNode(cc, CompK);
   compStmt->child[0] = NULL;
   compStmt->child[1] = NULL;
 
   func->lineno = 0;
-  func->attr.name = "output";
+  func->attr.name = intern(cc, "output");
   func->child[0] = typeSpec;
   func->child[1] = param;
   func->child[2] = compStmt;
 
-  st_insert("output", 0, addLocation(), func);
+  st_insert(cc, func->attr.name, 0, addLocation(cc, 1), func);
+}
+
+/* returnType returns the type of function t */
+static ExpType returnType(TreeNode *t)
+{
+  switch (t->child[0]->attr.type)
+  {
+  case INT:
+    return Integer;
+  case VOID:
+  default:
+    return Void;
+  }
+}
+
+/* paramType returns the type of parameter t */
+static ExpType paramType(TreeNode *t)
+{
+  if (t->kind.param == NonArrParamK)
+    return Integer;
+  else
+    return IntegerArray;
 }
 
 /* nullProc is a do-nothing procedure to 
  * generate preorder-only or postorder-only
  * traversals from traverse
  */
-static void nullProc(TreeNode *t)
+static void nullProc(Compiler cc, TreeNode *t)
 {
+  (void)cc;
   if (t == NULL)
     return;
   else
@@ -153,23 +249,23 @@ static void nullProc(TreeNode *t)
  * identifiers stored in t into 
  * the symbol table 
  */
-static void insertNode(TreeNode *t)
+static void insertNode(Compiler cc, TreeNode *t)
 {
+  Analyze a = stateOf(cc);
   switch (t->nodekind)
   {
   case StmtK:
     switch (t->kind.stmt)
     {
     case CompK:
-      if (inScopeBefore)
-        inScopeBefore = FALSE;
+      if (a->inScopeBefore)
+        a->inScopeBefore = FALSE;
       else
       {
-        ScopeList scope = sc_create(funcName);
-        sc_push(scope);
-        location++;
+        ScopeList scope = sc_create(cc, a->funcName);
+        sc_push(cc, scope);
       }
-      t->attr.scope = sc_top();
+      t->attr.scope = sc_top(cc);
       break;
     default:
       break;
@@ -181,14 +277,21 @@ static void insertNode(TreeNode *t)
     case IdK:
     case ArrIdK:
     case CallK:
+    {
+      ScopeList scope;
+      BucketList l = lookup(cc, t->attr.name, &scope);
       /* not yet in table, undeclared error */
-      if (st_lookup(t->attr.name) == -1)
-        undeclaredError(t);
+      if (l == NULL)
+        undeclaredError(cc, t);
+      /* a worker leaves the globals as they are */
+      else if (a->worker && scope == a->globalScope)
+        addUse(cc, l, t->lineno);
       /* already in table, so ignore location, 
              add line number of use only */
       else
-        st_add_lineno(t->attr.name, t->lineno);
+        st_add_line(cc, l, t->lineno);
       break;
+    }
     default:
       break;
     }
@@ -197,36 +300,35 @@ static void insertNode(TreeNode *t)
     switch (t->kind.decl)
     {
     case FuncK:
-      funcName = t->attr.name;
-      if (st_lookup_top(t->attr.name) >= 0)
+      a->funcName = t->attr.name;
+      /* a worker finds the function declared */
+      if (a->worker)
       {
-        redefinedError(t);
+        sc_push(cc, sc_create(cc, a->funcName));
+        a->inScopeBefore = TRUE;
         break;
       }
-      if (sc_top() != globalScope)
+      if (st_lookup_top(cc, t->attr.name) >= 0)
       {
-        funcDeclNotGlobal(t);
+        redefinedError(cc, t);
         break;
       }
-      st_insert(funcName, t->lineno, addLocation(), t);
-      sc_push(sc_create(funcName));
-      inScopeBefore = TRUE;
-
-      switch (t->child[0]->attr.type)
+      if (sc_top(cc) != a->globalScope)
       {
-      case INT:
-        t->type = Integer;
-        break;
-      case VOID:
-      default:
-        t->type = Void;
+        funcDeclNotGlobal(cc, t);
         break;
       }
+      st_insert(cc, a->funcName, t->lineno, addLocation(cc, 1), t);
+      sc_push(cc, sc_create(cc, a->funcName));
+      a->inScopeBefore = TRUE;
+      t->type = returnType(t);
       break;
     case VarK:
     case ArrVarK:
     {
       char *name;
+      if (a->worker && sc_top(cc) == a->globalScope)
+        break;
       if (t->kind.decl == VarK)
       {
         name = t->attr.name;
@@ -238,12 +340,14 @@ static void insertNode(TreeNode *t)
         t->type = IntegerArray;
       }
 
-      if (st_lookup_top(name) < 0)
+      if (st_lookup_top(cc, name) < 0)
       {
-        st_insert(name, t->lineno, addLocation(), t);
+        /* an array reserves a location per element */
+        int size = t->kind.decl == VarK ? 1 : t->attr.arr.size;
+        st_insert(cc, name, t->lineno, addLocation(cc, size), t);
       }
       else
-        redefinedError(t);
+        redefinedError(cc, t);
     }
     break;
     default:
@@ -256,13 +360,13 @@ static void insertNode(TreeNode *t)
       break;
     }
 
-    if (st_lookup(t->attr.name) == -1)
+    /* a parameter may hide a global of the same name */
+    if (st_lookup_top(cc, t->attr.name) == -1)
     {
-      st_insert(t->attr.name, t->lineno, addLocation(), t);
-      if (t->kind.param == NonArrParamK)
-        t->type = Integer;
-      else
-        t->type = IntegerArray;
+      st_insert(cc, t->attr.name, t->lineno, addLocation(cc, 1), t);
+      /* a worker finds the parameters typed */
+      if (!a->worker)
+        t->type = paramType(t);
     }
     break;
   default:
@@ -270,33 +374,322 @@ static void insertNode(TreeNode *t)
   }
 }
 
-static void afterInsertNode(TreeNode *t)
+static void afterInsertNode(Compiler cc, TreeNode *t)
 {
   if (t->nodekind == StmtK && t->kind.stmt == CompK)
-    sc_pop();
+    sc_pop(cc);
+}
+
+/**************************************************/
+/***********   Parallel analysis       ************/
+/**************************************************/
+
+/* A parallel analysis inserts the globals and the
+ * signatures of the functions first, in source
+ * order, and then analyzes each top-level
+ * declaration on its own in a worker context, with
+ * a scope stack of its own over the global scope.
+ * A body sees only the globals declared before it,
+ * as it would in one traversal. What the workers
+ * print, the scopes they create and their uses of
+ * globals are merged in source order, so the
+ * listing and the symbol table are those of the
+ * serial analysis
+ */
+
+/* a top-level declaration analyzed by a worker,
+ * with the parts of what the worker printed, the
+ * scopes it created and its uses of globals that
+ * the analysis of the declaration made
+ */
+typedef struct
+{
+  TreeNode *t;
+  TreeNode *sibling; /* of t, cut while t is analyzed */
+  int visible;       /* globals declared up to t */
+  struct WorkerRec *worker;
+  size_t textFrom, textTo;
+  int scopeFrom, scopeTo;
+  int useFrom, useTo;
+} Unit;
+
+/* the units shared by the workers */
+typedef struct
+{
+  Unit *units;
+  int n;
+  int next; /* the next unit to analyze */
+  pthread_mutex_t lock;
+  void (*preProc)(Compiler, TreeNode *);
+  void (*postProc)(Compiler, TreeNode *);
+} UnitPool;
+
+typedef struct WorkerRec
+{
+  UnitPool *pool;
+  Compiler cc;
+  char *text; /* what it printed */
+  size_t size;
+  ScopeList *scopes; /* the scopes it created */
+  int scopeCount;
+  pthread_t thread;
+  int started; /* TRUE if the worker has a thread */
+} Worker;
+
+/* declName returns the name declared by t */
+static char *declName(TreeNode *t)
+{
+  return t->kind.decl == ArrVarK ? t->attr.arr.name : t->attr.name;
+}
+
+/* uniqueGlobals returns TRUE if the n top-level
+ * declarations of syntaxTree declare n distinct
+ * names, none of them declared yet; a name
+ * declared again is an error whose effects the
+ * workers cannot share
+ */
+static int uniqueGlobals(Compiler cc, TreeNode *syntaxTree, int n)
+{
+  int size = 16, i, ok = TRUE;
+  char **names;
+  TreeNode *t;
+  while (size < 2 * n)
+    size *= 2;
+  names = (char **)calloc(size, sizeof(char *));
+  if (names == NULL)
+    return FALSE;
+  for (t = syntaxTree; ok && t != NULL; t = t->sibling)
+  {
+    char *name;
+    if (t->nodekind != DeclK || st_lookup_top(cc, declName(t)) >= 0)
+    {
+      ok = FALSE;
+      break;
+    }
+    name = declName(t);
+    for (i = (int)(((unsigned)internHash(name) * 2654435761u) & (unsigned)(size - 1));
+         names[i] != NULL; i = (i + 1) & (size - 1))
+      if (names[i] == name)
+        ok = FALSE;
+    names[i] = name;
+  }
+  free(names);
+  return ok;
+}
+
+/* typeDecl types top-level declaration t as
+ * insertNode would, a function with its parameters
+ */
+static void typeDecl(TreeNode *t)
+{
+  TreeNode *p, *q;
+  if (t->kind.decl == VarK)
+  {
+    t->type = Integer;
+    return;
+  }
+  if (t->kind.decl == ArrVarK)
+  {
+    t->type = IntegerArray;
+    return;
+  }
+  t->type = returnType(t);
+  for (p = t->child[1]; p != NULL; p = p->sibling)
+  {
+    if (p->child[0]->attr.type == VOID)
+      continue;
+    /* a parameter declared again is not typed */
+    for (q = t->child[1]; q != p; q = q->sibling)
+      if (q->child[0]->attr.type != VOID && q->attr.name == p->attr.name)
+        break;
+    if (q == p)
+      p->type = paramType(p);
+  }
+}
+
+/* declareGlobal inserts top-level declaration t
+ * into the global scope as insertNode would, with
+ * the types of a function and its parameters
+ */
+static void declareGlobal(Compiler cc, TreeNode *t)
+{
+  if (t->kind.decl != FuncK)
+  {
+    insertNode(cc, t);
+    return;
+  }
+  st_insert(cc, t->attr.name, t->lineno, addLocation(cc, 1), t);
+  typeDecl(t);
+}
+
+/* analyzeUnits analyzes units of the pool in the
+ * context of worker w until none is left
+ */
+static void *analyzeUnits(void *arg)
+{
+  Worker *w = (Worker *)arg;
+  UnitPool *pool = w->pool;
+  Analyze a = stateOf(w->cc);
+  Unit *u;
+  for (;;)
+  {
+    pthread_mutex_lock(&pool->lock);
+    u = (pool->next < pool->n) ? &pool->units[pool->next++] : NULL;
+    pthread_mutex_unlock(&pool->lock);
+    if (u == NULL)
+      return NULL;
+    u->worker = w;
+    a->visible = u->visible;
+    u->textFrom = w->size;
+    u->scopeFrom = st_scope_count(w->cc);
+    u->useFrom = a->useCount;
+    traverse(w->cc, u->t, pool->preProc, pool->postProc);
+    fflush(w->cc->listing);
+    u->textTo = w->size;
+    u->scopeTo = st_scope_count(w->cc);
+    u->useTo = a->useCount;
+  }
+}
+
+/* analyzeParallel analyzes syntaxTree with preProc
+ * and postProc on AnalyzeThreads workers, the
+ * globals declared first if declare is TRUE, and
+ * returns TRUE; it returns FALSE, doing nothing,
+ * if the program is better analyzed serially
+ */
+static int analyzeParallel(Compiler cc, TreeNode *syntaxTree, int declare,
+                           void (*preProc)(Compiler, TreeNode *),
+                           void (*postProc)(Compiler, TreeNode *))
+{
+  Analyze a = stateOf(cc);
+  UnitPool pool;
+  Worker *workers;
+  Unit *u;
+  TreeNode *t;
+  int n = 0, nThreads = AnalyzeThreads, i, k;
+  for (t = syntaxTree; t != NULL; t = t->sibling)
+    n++;
+  if (nThreads < 2 || n < ANALYZEMIN)
+    return FALSE;
+  if (declare && !uniqueGlobals(cc, syntaxTree, n))
+    return FALSE;
+  if (nThreads > n)
+    nThreads = n;
+  pool.units = (Unit *)calloc(n, sizeof(Unit));
+  workers = (Worker *)calloc(nThreads, sizeof(Worker));
+  if (pool.units == NULL || workers == NULL)
+  {
+    fprintf(cc->listing, "Out of memory error in the analyzer\n");
+    exit(1);
+  }
+  for (t = syntaxTree, i = 0; t != NULL; t = t->sibling, i++)
+  {
+    u = &pool.units[i];
+    u->t = t;
+    if (declare)
+    {
+      declareGlobal(cc, t);
+      u->visible = a->globalScope->symCount;
+    }
+    else
+      u->visible = INT_MAX;
+  }
+  for (i = 0; i < n; i++)
+  {
+    u = &pool.units[i];
+    u->sibling = u->t->sibling;
+    u->t->sibling = NULL;
+  }
+  pool.n = n;
+  pool.next = 0;
+  pool.preProc = preProc;
+  pool.postProc = postProc;
+  pthread_mutex_init(&pool.lock, NULL);
+  for (i = 0; i < nThreads; i++)
+  {
+    Analyze wa;
+    FILE *listing = open_memstream(&workers[i].text, &workers[i].size);
+    if (listing == NULL)
+    {
+      fprintf(cc->listing, "Out of memory error in the analyzer\n");
+      exit(1);
+    }
+    workers[i].pool = &pool;
+    workers[i].cc = newCompiler(NULL, listing);
+    wa = stateOf(workers[i].cc);
+    wa->globalScope = a->globalScope;
+    wa->worker = TRUE;
+    wa->fused = a->fused;
+    sc_push(workers[i].cc, a->globalScope);
+  }
+  /* the first worker runs on this thread, and so
+     takes all units if no other thread starts */
+  for (i = 1; i < nThreads; i++)
+    workers[i].started =
+        (pthread_create(&workers[i].thread, NULL, analyzeUnits, &workers[i]) == 0);
+  analyzeUnits(&workers[0]);
+  for (i = 1; i < nThreads; i++)
+    if (workers[i].started)
+      pthread_join(workers[i].thread, NULL);
+  pthread_mutex_destroy(&pool.lock);
+  for (i = 0; i < nThreads; i++)
+  {
+    fclose(workers[i].cc->listing);
+    workers[i].cc->listing = cc->listing;
+    workers[i].scopes = st_take_scopes(workers[i].cc, &workers[i].scopeCount);
+  }
+  /* what the units did, in source order */
+  for (i = 0; i < n; i++)
+  {
+    Worker *w;
+    Analyze wa;
+    u = &pool.units[i];
+    u->t->sibling = u->sibling;
+    w = u->worker;
+    fwrite(w->text + u->textFrom, 1, u->textTo - u->textFrom, cc->listing);
+    st_give_scopes(cc, w->scopes + u->scopeFrom, u->scopeTo - u->scopeFrom);
+    wa = stateOf(w->cc);
+    for (k = u->useFrom; k < u->useTo; k++)
+      st_add_line(cc, wa->uses[k].l, wa->uses[k].lineno);
+  }
+  for (i = 0; i < nThreads; i++)
+  {
+    if (workers[i].cc->Error)
+      cc->Error = TRUE;
+    free(workers[i].text);
+    free(workers[i].scopes);
+    arenaAdopt(cc, workers[i].cc);
+    freeCompiler(workers[i].cc);
+  }
+  free(workers);
+  free(pool.units);
+  return TRUE;
 }
 
 /* Function buildSymtab constructs the symbol 
  * table by preorder traversal of the syntax tree
  */
-void buildSymtab(TreeNode *syntaxTree)
+void buildSymtab(Compiler cc, TreeNode *syntaxTree)
 {
-  globalScope = sc_create("global");
-  sc_push(globalScope);
-  insertIOFuncNode();
-  traverse(syntaxTree, insertNode, afterInsertNode);
-  sc_pop();
+  Analyze a = stateOf(cc);
+  a->globalScope = sc_create(cc, "global");
+  sc_push(cc, a->globalScope);
+  insertIOFuncNode(cc);
+  if (!analyzeParallel(cc, syntaxTree, TRUE, insertNode, afterInsertNode))
+    traverse(cc, syntaxTree, insertNode, afterInsertNode);
+  sc_pop(cc);
 }
 
-static void beforeCheckNode(TreeNode *t)
+static void beforeCheckNode(Compiler cc, TreeNode *t)
 {
+  Analyze a = stateOf(cc);
   switch (t->nodekind)
   {
   case DeclK:
     switch (t->kind.decl)
     {
     case FuncK:
-      funcName = t->attr.name;
+      a->funcName = t->attr.name;
       break;
     default:
       break;
@@ -306,7 +699,7 @@ static void beforeCheckNode(TreeNode *t)
     switch (t->kind.stmt)
     {
     case CompK:
-      sc_push(t->attr.scope);
+      sc_push(cc, t->attr.scope);
       break;
     default:
       break;
@@ -317,39 +710,72 @@ static void beforeCheckNode(TreeNode *t)
   }
 }
 
+/* declOf returns the declaration of name that the
+ * type check of a use sees, NULL if there is none.
+ * After two passes a global declared after the use
+ * is in the table; a single traversal finds it
+ * among the top-level declarations instead, so the
+ * two report the same errors
+ */
+static TreeNode *declOf(Compiler cc, char *name)
+{
+  Analyze a = stateOf(cc);
+  ScopeList scope;
+  BucketList l = lookup(cc, name, &scope);
+  TreeNode *t;
+  if (l != NULL)
+    return l->treeNode;
+  if (!a->fused)
+    return NULL;
+  /* a worker has all the globals declared */
+  if (a->worker)
+  {
+    l = get_bucket_at(cc, name, &scope);
+    return l != NULL ? l->treeNode : NULL;
+  }
+  for (t = a->tree; t != NULL; t = t->sibling)
+    if (t->nodekind == DeclK && declName(t) == name)
+    {
+      typeDecl(t);
+      return t;
+    }
+  return NULL;
+}
+
 /* Procedure checkNode performs
  * type checking at a single tree node
  */
-static void checkNode(TreeNode *t)
+static void checkNode(Compiler cc, TreeNode *t)
 {
+  Analyze a = stateOf(cc);
   switch (t->nodekind)
   {
   case StmtK:
     switch (t->kind.stmt)
     {
     case CompK:
-      sc_pop();
+      sc_pop(cc);
       break;
     case IfK:
     case IfEK:
       if (t->child[0] == NULL)
-        typeError(t, "expected expression");
+        typeError(cc, t, "expected expression");
       else if (t->child[0]->type == Void)
-        typeError(t->child[0], "invalid if condition type");
+        typeError(cc, t->child[0], "invalid if condition type");
       break;
     case IterK:
       if (t->child[0] == NULL)
-        typeError(t, "expected expression");
+        typeError(cc, t, "expected expression");
       else if (t->child[0]->type == Void)
-        typeError(t->child[0], "invalid loop condition type");
+        typeError(cc, t->child[0], "invalid loop condition type");
       break;
     case RetK:
     {
-      TreeNode *retFunc = get_bucket(funcName)->treeNode;
+      TreeNode *retFunc = get_bucket(cc, a->funcName)->treeNode;
       if ((retFunc->type == Void && t->child[0] != NULL) ||
           (retFunc->type == Integer &&
            (t->child[0] == NULL || t->child[0]->type == Void || t->child[0]->type == IntegerArray)))
-        typeError(t, "invalid return type");
+        typeError(cc, t, "invalid return type");
       break;
     }
     default:
@@ -361,11 +787,11 @@ static void checkNode(TreeNode *t)
     {
     case AssignK:
       if (t->child[0]->type == Void || t->child[1]->type == Void)
-        typeError(t->child[0], "invalid variable type");
+        typeError(cc, t->child[0], "invalid variable type");
       else if (t->child[0]->type == IntegerArray && t->child[0]->child[0] == NULL)
-        typeError(t->child[0], "invalid variable type");
+        typeError(cc, t->child[0], "invalid variable type");
       else if (t->child[1]->type == IntegerArray && t->child[1]->child[0] == NULL)
-        typeError(t->child[0], "invalid variable type");
+        typeError(cc, t->child[0], "invalid variable type");
       else
         t->type = t->child[0]->type;
       break;
@@ -384,7 +810,7 @@ static void checkNode(TreeNode *t)
         rType = Integer;
 
       if ((lType == Void || rType == Void) || (lType != rType))
-        typeError(t, "invalid expression");
+        typeError(cc, t, "invalid expression");
       else
         t->type = Integer;
       break;
@@ -395,17 +821,14 @@ static void checkNode(TreeNode *t)
     case IdK:
     case ArrIdK:
     {
-      BucketList l = get_bucket(t->attr.name);
-      if (l == NULL)
+      TreeNode *symbolNode = declOf(cc, t->attr.name);
+      if (symbolNode == NULL)
         break;
 
-      TreeNode *symbolNode = NULL;
-      symbolNode = l->treeNode;
-
       if (t->kind.exp == ArrIdK)
       {
         if ((symbolNode->nodekind == DeclK && symbolNode->kind.decl != ArrVarK) || (symbolNode->nodekind == ParamK && symbolNode->kind.param != ArrParamK))
-          typeError(t, "invalid expression");
+          typeError(cc, t, "invalid expression");
         else
           t->type = symbolNode->type;
       }
@@ -415,20 +838,18 @@ static void checkNode(TreeNode *t)
     }
     case CallK:
     {
-      BucketList l = get_bucket(t->attr.name);
-      TreeNode *funcNode = NULL;
+      TreeNode *funcNode = declOf(cc, t->attr.name);
       TreeNode *arg;
       TreeNode *param;
 
-      if (l == NULL)
+      if (funcNode == NULL)
         break;
-      funcNode = l->treeNode;
       arg = t->child[0];
       param = funcNode->child[1];
 
       if (funcNode->kind.decl != FuncK)
       {
-        typeError(t, "invalid expression");
+        typeError(cc, t, "invalid expression");
         break;
       }
 
@@ -436,7 +857,7 @@ static void checkNode(TreeNode *t)
       {
         if (param == NULL || arg->type == Void)
         {
-          typeError(arg, "invalid function call");
+          typeError(cc, arg, "invalid function call");
           break;
         }
         ExpType pType = param->type;
@@ -446,7 +867,7 @@ static void checkNode(TreeNode *t)
 
         if (pType != aType)
         {
-          typeError(arg, "invalid function call");
+          typeError(cc, arg, "invalid function call");
           break;
         }
         else
@@ -457,7 +878,7 @@ static void checkNode(TreeNode *t)
       }
       if (arg == NULL && param != NULL && param->child[0]->attr.type != VOID)
       {
-        typeError(t->child[0], "invalid function call");
+        typeError(cc, t->child[0], "invalid function call");
       }
 
       t->type = funcNode->type;
@@ -479,7 +900,7 @@ static void checkNode(TreeNode *t)
           name = t->attr.name;
         else
           name = t->attr.arr.name;
-        voidVarError(t, name);
+        voidVarError(cc, t, name);
         break;
       }
       break;
@@ -495,9 +916,29 @@ static void checkNode(TreeNode *t)
 /* Procedure typeCheck performs type checking 
  * by a postorder syntax tree traversal
  */
-void typeCheck(TreeNode *syntaxTree)
+void typeCheck(Compiler cc, TreeNode *syntaxTree)
+{
+  Analyze a = stateOf(cc);
+  sc_push(cc, a->globalScope);
+  if (!analyzeParallel(cc, syntaxTree, FALSE, beforeCheckNode, checkNode))
+    traverse(cc, syntaxTree, beforeCheckNode, checkNode);
+  sc_pop(cc);
+}
+
+/* Procedure analyze builds the symbol table and
+ * performs type checking in one traversal:
+ * insertNode runs in preorder and checkNode,
+ * which also closes the scopes, in postorder
+ */
+void analyze(Compiler cc, TreeNode *syntaxTree)
 {
-  sc_push(globalScope);
-  traverse(syntaxTree, beforeCheckNode, checkNode);
-  sc_pop();
+  Analyze a = stateOf(cc);
+  a->fused = TRUE;
+  a->tree = syntaxTree;
+  a->globalScope = sc_create(cc, "global");
+  sc_push(cc, a->globalScope);
+  insertIOFuncNode(cc);
+  if (!analyzeParallel(cc, syntaxTree, TRUE, insertNode, checkNode))
+    traverse(cc, syntaxTree, insertNode, checkNode);
+  sc_pop(cc);
 }
@@ -11,11 +11,26 @@
 /* Function buildSymtab constructs the symbol 
  * table by preorder traversal of the syntax tree
  */
-void buildSymtab(TreeNode *);
+void buildSymtab(Compiler, TreeNode *);
 
 /* Procedure typeCheck performs type checking 
  * by a postorder syntax tree traversal
  */
-void typeCheck(TreeNode *);
+void typeCheck(Compiler, TreeNode *);
+
+/* Procedure analyze builds the symbol table and
+ * performs type checking in one traversal; names
+ * are declared before use, so each node is checked
+ * once the declarations it refers to are inserted.
+ * The errors are those of buildSymtab and
+ * typeCheck, but reported as they are met, the
+ * declaration and type errors interleaved
+ */
+void analyze(Compiler, TreeNode *);
+
+/* Procedure analyzeFree releases the analysis
+ * state of a compilation
+ */
+void analyzeFree(Compiler);
 
 #endif
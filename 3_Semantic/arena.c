@@ -0,0 +1,125 @@
+/****************************************************/
+/* File: arena.c                                    */
+/* Arena allocator for the syntax tree and strings  */
+/* of one compilation                               */
+/****************************************************/
+
+#include "globals.h"
+#include "arena.h"
+
+/* ARENA_CHUNK is the usual size of a chunk;
+   larger requests get a chunk of their own */
+#define ARENA_CHUNK 65536
+
+/* allocations are aligned to ARENA_ALIGN bytes */
+#define ARENA_ALIGN 16
+
+typedef struct ArenaChunkRec
+{ struct ArenaChunkRec * next;
+  int size; /* bytes in data */
+  int used; /* bytes of data handed out */
+  char data[1];
+} * ArenaChunk;
+
+/* the arena of a compilation: its chunks, the
+   one being filled first, and the statistics
+   for arenaStats */
+struct ArenaRec
+{ ArenaChunk chunks;
+  int allocCount[ArenaOther+1];
+  long allocBytes[ArenaOther+1];
+  int chunkCount;
+  long chunkBytes;
+};
+
+static char * kindName[] = { "nodes", "strings", "other" };
+
+static void outOfMemory( Compiler cc )
+{ fprintf(cc->listing,"Out of memory error at line %d\n",cc->lineno);
+  exit(1);
+}
+
+void * arenaAlloc( Compiler cc, int size, ArenaKind kind )
+{ struct ArenaRec * a = cc->arena;
+  ArenaChunk c;
+  void * p;
+  if (a == NULL)
+  { a = cc->arena = (struct ArenaRec *) calloc(1,sizeof(struct ArenaRec));
+    if (a == NULL) outOfMemory(cc);
+  }
+  c = a->chunks;
+  size = (size + ARENA_ALIGN-1) & ~(ARENA_ALIGN-1);
+  if ((c == NULL) || (c->used + size > c->size))
+  { int n = size > ARENA_CHUNK ? size : ARENA_CHUNK;
+    c = (ArenaChunk) malloc(sizeof(struct ArenaChunkRec) + n + ARENA_ALIGN);
+    if (c == NULL) outOfMemory(cc);
+    /* start data at an ARENA_ALIGN boundary */
+    c->used = (int) (-(unsigned long) c->data & (ARENA_ALIGN-1));
+    c->size = c->used + n;
+    c->next = a->chunks;
+    a->chunks = c;
+    a->chunkCount++;
+    a->chunkBytes += n;
+  }
+  p = c->data + c->used;
+  c->used += size;
+  a->allocCount[kind]++;
+  a->allocBytes[kind] += size;
+  return p;
+}
+
+void arenaFree( Compiler cc )
+{ struct ArenaRec * a = cc->arena;
+  ArenaChunk c;
+  if (a == NULL) return;
+  while (a->chunks != NULL)
+  { c = a->chunks;
+    a->chunks = c->next;
+    free(c);
+  }
+  free(a);
+  cc->arena = NULL;
+}
+
+void arenaAdopt( Compiler cc, Compiler from )
+{ struct ArenaRec * a, * b = from->arena;
+  ArenaChunk c;
+  int k;
+  if (b == NULL) return;
+  a = cc->arena;
+  if (a == NULL)
+  { cc->arena = b;
+    from->arena = NULL;
+    return;
+  }
+  /* the chunks of from go after the one being
+     filled, which stays first */
+  if (b->chunks != NULL)
+  { for (c = b->chunks; c->next != NULL; c = c->next) ;
+    if (a->chunks == NULL) a->chunks = b->chunks;
+    else
+    { c->next = a->chunks->next;
+      a->chunks->next = b->chunks;
+    }
+  }
+  for (k = 0; k <= ArenaOther; k++)
+  { a->allocCount[k] += b->allocCount[k];
+    a->allocBytes[k] += b->allocBytes[k];
+  }
+  a->chunkCount += b->chunkCount;
+  a->chunkBytes += b->chunkBytes;
+  free(b);
+  from->arena = NULL;
+}
+
+void arenaStats( Compiler cc )
+{ struct ArenaRec * a = cc->arena;
+  int k;
+  if (a == NULL) return;
+  fprintf(cc->listing,"\nArena allocation:\n");
+  for (k = 0; k <= ArenaOther; k++)
+    fprintf(cc->listing,"  %-8s %8d allocations %10ld bytes\n",
+            kindName[k],a->allocCount[k],a->allocBytes[k]);
+  fprintf(cc->listing,"  chunks   %8d             %10ld bytes\n",
+          a->chunkCount,a->chunkBytes);
+}
@@ -0,0 +1,36 @@
+/****************************************************/
+/* File: arena.h                                    */
+/* Arena allocator for the syntax tree and strings  */
+/* of one compilation                               */
+/****************************************************/
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+/* what an arena allocation is used for,
+   counted separately by arenaStats */
+typedef enum { ArenaNode, ArenaString, ArenaOther } ArenaKind;
+
+/* Function arenaAlloc returns size bytes of
+ * memory from the arena of cc; it exits on failure
+ */
+void * arenaAlloc( Compiler cc, int size, ArenaKind kind );
+
+/* Procedure arenaFree releases all memory
+ * of the arena of cc at once
+ */
+void arenaFree( Compiler cc );
+
+/* Procedure arenaAdopt moves the memory of the
+ * arena of from, with its statistics, to the
+ * arena of cc, which then releases it
+ */
+void arenaAdopt( Compiler cc, Compiler from );
+
+/* Procedure arenaStats prints the number of
+ * allocations and bytes of the arena of cc to
+ * the listing file
+ */
+void arenaStats( Compiler cc );
+
+#endif
@@ -0,0 +1,89 @@
+/****************************************************/
+/* File: bench/analyze.c                            */
+/* Throughput benchmark for the semantic analyzer:  */
+/* analyzes a program of the given number of        */
+/* functions in two passes and fused, on 1, 2 and   */
+/* 4 threads, and reports functions/s               */
+/* usage: analyze <functions>                       */
+/****************************************************/
+
+#include <time.h>
+#include "../globals.h"
+#include "../parse.h"
+#include "../analyze.h"
+#include "../compiler.h"
+
+static double now( void )
+{ struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* name writes the letters of n after prefix to s */
+static char * name( char * s, char prefix, long n )
+{ int i = 0;
+  s[i++] = prefix;
+  do s[i++] = 'a' + (int) (n % 26); while ((n /= 26) > 0);
+  s[i] = '\0';
+  return s;
+}
+
+/* writeSource writes funcs functions, each with a
+   global of its own and a call of the one before,
+   and a main to f */
+static void writeSource( FILE * f, long funcs )
+{ char fn[16], prev[16], g[16];
+  long i;
+  for (i = 0; i < funcs; i++)
+  { fprintf(f,"int %s[10];\n",name(g,'g',i));
+    fprintf(f,"int %s(int a, int b[])\n",name(fn,'f',i));
+    fprintf(f,"{ int index; int sum;\n  index = 0; sum = %s[0];\n",g);
+    fprintf(f,"  while (index < a) { int t; t = b[index] * index;"
+              " sum = sum + t; index = index + 1; }\n");
+    if (i > 0) fprintf(f,"  sum = sum + %s(a - 1, b);\n",name(prev,'f',i - 1));
+    fprintf(f,"  if (sum > 100) return sum / 2; else return sum - a;\n}\n");
+  }
+  fprintf(f,"void main(void)\n{ int x[10]; output(%s(3, x)); }\n",fn);
+}
+
+/* analyzeSource parses source and reports the time
+   its analysis takes */
+static void analyzeSource( FILE * source, long funcs )
+{ Compiler cc;
+  TreeNode * t;
+  double start, secs;
+  rewind(source);
+  cc = newCompiler(source,stdout);
+  t = parse(cc);
+  start = now();
+  if (FuseAnalysis) analyze(cc,t);
+  else
+  { buildSymtab(cc,t);
+    typeCheck(cc,t);
+  }
+  secs = now() - start;
+  printf("%8ld functions, %-9s %d threads: %.3f s, %9.0f functions/s\n",funcs,
+         FuseAnalysis ? "fused," : "2 passes,",AnalyzeThreads,secs,funcs / secs);
+  if (cc->Error) printf("analysis failed\n");
+  freeCompiler(cc);
+}
+
+int main( int argc, char * argv[] )
+{ FILE * source;
+  long funcs;
+  if ((argc != 2) || ((funcs = atol(argv[1])) < 1))
+  { fprintf(stderr,"usage: %s <functions>\n",argv[0]);
+    exit(1);
+  }
+  source = tmpfile();
+  if (source == NULL)
+  { fprintf(stderr,"Unable to open a temporary file\n");
+    exit(1);
+  }
+  writeSource(source,funcs);
+  for (FuseAnalysis = FALSE; FuseAnalysis <= TRUE; FuseAnalysis++)
+    for (AnalyzeThreads = 1; AnalyzeThreads <= 4; AnalyzeThreads *= 2)
+      analyzeSource(source,funcs);
+  fclose(source);
+  return 0;
+}
@@ -0,0 +1,87 @@
+/****************************************************/
+/* File: bench/driver.c                             */
+/* Throughput benchmark for the compilation driver: */
+/* compiles many programs on 1, 2, 4, ... threads   */
+/* up to the number of cores and reports files/s    */
+/* usage: driver [files]                            */
+/****************************************************/
+
+#include <time.h>
+#include <unistd.h>
+#include "../globals.h"
+#include "../driver.h"
+
+#define NFILES 2000 /* default number of programs */
+#define NFUNCS 40   /* functions in each program */
+
+static double now( void )
+{ struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* writeProgram writes a program of NFUNCS small
+   functions and a main calling them to file */
+static void writeProgram( const char * file, int seed )
+{ FILE * f = fopen(file,"w");
+  int i;
+  if (f == NULL)
+  { fprintf(stderr,"Unable to open %s\n",file);
+    exit(1);
+  }
+  fprintf(f,"int g[10];\n");
+  for (i = 0; i < NFUNCS; i++)
+  { fprintf(f,"int f%c%c(int a, int b[])\n",'a' + i / 26,'a' + i % 26);
+    fprintf(f,"{ int i; int s;\n  i = 0; s = %d;\n",seed + i);
+    fprintf(f,"  while (i < a) { s = s + b[i] * i; i = i + 1; }\n");
+    fprintf(f,"  if (s > 100) return s / 2; else return s - a;\n}\n");
+  }
+  fprintf(f,"void main(void)\n{ int x; x = 0;\n");
+  for (i = 0; i < NFUNCS; i++)
+    fprintf(f,"  x = x + f%c%c(%d, g);\n",'a' + i / 26,'a' + i % 26,i % 10);
+  fprintf(f,"  output(x);\n}\n");
+  fclose(f);
+}
+
+int main( int argc, char * argv[] )
+{ char dir[] = "/tmp/cmbenchXXXXXX";
+  char ** pgms;
+  FILE * null;
+  int nFiles = (argc > 1) ? atoi(argv[1]) : NFILES;
+  int cores = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  int i, t, last;
+  double start, secs;
+  TraceAnalyze = TRUE;
+  if ((nFiles < 1) || (mkdtemp(dir) == NULL))
+  { fprintf(stderr,"usage: %s [files]\n",argv[0]);
+    exit(1);
+  }
+  pgms = (char **) malloc(nFiles * sizeof(char *));
+  null = fopen("/dev/null","w");
+  for (i = 0; i < nFiles; i++)
+  { pgms[i] = (char *) malloc(sizeof(dir) + 16);
+    sprintf(pgms[i],"%s/p%d.cm",dir,i);
+    writeProgram(pgms[i],i);
+  }
+  printf("%d files, %d cores\n",nFiles,cores);
+  for (t = 1, last = 0; !last; t *= 2)
+  { if (t >= cores)
+    { t = cores;
+      last = TRUE;
+    }
+    start = now();
+    if (compileFiles(pgms,nFiles,t,null) != 0) printf("compile failed\n");
+    secs = now() - start;
+    printf("%3d threads: %8.0f files/s\n",t,nFiles / secs);
+  }
+  for (i = 0; i < nFiles; i++)
+  { remove(pgms[i]);
+    strcpy(strrchr(pgms[i],'.'),".tm");
+    remove(pgms[i]);
+    free(pgms[i]);
+  }
+  rmdir(dir);
+  fclose(null);
+  free(pgms);
+  return 0;
+}
@@ -0,0 +1,33 @@
+* Benchmark: recursive fibonacci, fib(27)
+* argument and result in reg 0, return address in reg 1,
+* stack pointer in reg 6 grows down from the top of dMem
+  0:     LD  6,0(0)      load maxaddress from location 0
+  1:     ST  0,0(0)      clear location 0
+  2:    LDC  0,27(0)     n
+  3:    LDA  1,1(7)      return address
+  4:    LDC  7,7(0)      call fib
+  5:    OUT  0,0,0       print fib(n)
+  6:   HALT  0,0,0
+* fib:
+  7:     ST  1,0(6)      push return address
+  8:    LDA  6,-1(6)
+  9:    LDC  2,2(0)
+ 10:    SUB  2,0,2       n-2
+ 11:    JLT  2,15(7)     n<2: return n
+ 12:     ST  0,0(6)      push n
+ 13:    LDA  6,-1(6)
+ 14:    LDC  2,1(0)
+ 15:    SUB  0,0,2       n-1
+ 16:    LDA  1,1(7)      return address
+ 17:    LDC  7,7(0)      call fib(n-1)
+ 18:     LD  2,1(6)      n
+ 19:     ST  0,1(6)      keep fib(n-1)
+ 20:    LDC  3,2(0)
+ 21:    SUB  0,2,3       n-2
+ 22:    LDA  1,1(7)      return address
+ 23:    LDC  7,7(0)      call fib(n-2)
+ 24:     LD  2,1(6)      fib(n-1)
+ 25:    ADD  0,0,2
+ 26:    LDA  6,1(6)      pop
+ 27:    LDA  6,1(6)      pop return address
+ 28:     LD  7,0(6)      return
@@ -0,0 +1,24 @@
+/****************************************************/
+/* File: bench/flags.c                              */
+/* The flags of globals.h for the benchmarks: no    */
+/* tracing, and the modes main.c starts in; each    */
+/* benchmark sets the flags it varies               */
+/****************************************************/
+
+#include "../globals.h"
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+int BinaryCode = FALSE;
+int OptimizeCode = FALSE;
+int TraceMemory = FALSE;
+int FuseAnalysis = FALSE;
+int MapSource = TRUE;
+int TableScan = TRUE;
+int BatchTokens = TRUE;
+int PipelineScan = FALSE;
+int ParseThreads = 1;
+int AnalyzeThreads = 1;
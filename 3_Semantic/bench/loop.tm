@@ -0,0 +1,13 @@
+* Benchmark: nested counting loop (1000 x 10000)
+* prints the number of inner iterations
+  0:    LDC  1,1000(0)   outer counter
+  1:    LDC  3,1(0)      constant 1
+  2:    LDC  0,0(0)      accumulator
+  3:    LDC  2,10000(0)  inner counter
+  4:    ADD  0,0,3       inner body: acc++
+  5:    SUB  2,2,3       inner--
+  6:    JGT  2,-3(7)     repeat inner
+  7:    SUB  1,1,3       outer--
+  8:    JGT  1,-6(7)     repeat outer
+  9:    OUT  0,0,0       print acc
+ 10:   HALT  0,0,0
@@ -0,0 +1,47 @@
+/****************************************************/
+/* File: bench/parse.c                              */
+/* Parse benchmark for the C-MINUS compiler:        */
+/* times the parser on a function of n statements,  */
+/* with tokens read one at a time and in batches    */
+/* usage: parse <n>                                 */
+/****************************************************/
+
+#include <time.h>
+#include "../globals.h"
+#include "../parse.h"
+#include "../compiler.h"
+
+int main( int argc, char * argv[] )
+{ Compiler cc;
+  FILE * source;
+  TreeNode * t;
+  clock_t start;
+  int i, n;
+  if (argc != 2)
+  { fprintf(stderr,"usage: %s <n>\n",argv[0]);
+    exit(1);
+  }
+  n = atoi(argv[1]);
+  source = tmpfile();
+  if (source == NULL)
+  { fprintf(stderr,"Unable to open a temporary file\n");
+    exit(1);
+  }
+  fprintf(source,"void main(void)\n{ int x; int a[10];\n");
+  for (i = 0; i < n; i++)
+    fprintf(source,"  x = a[%d] + output(x, %d);\n",i % 10,i);
+  fprintf(source,"}\n");
+  for (BatchTokens = FALSE; BatchTokens <= TRUE; BatchTokens++)
+  { rewind(source);
+    cc = newCompiler(source,stdout);
+    start = clock();
+    t = parse(cc);
+    printf("%8d statements, %-7s tokens: %.3f s\n",n,
+           BatchTokens ? "batched" : "single",
+           (double) (clock() - start) / CLOCKS_PER_SEC);
+    if (cc->Error || (t == NULL)) printf("parse failed\n");
+    freeCompiler(cc);
+  }
+  fclose(source);
+  return 0;
+}
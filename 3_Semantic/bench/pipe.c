@@ -0,0 +1,84 @@
+/****************************************************/
+/* File: bench/pipe.c                               */
+/* Pipeline benchmark for the C-MINUS compiler:     */
+/* times the parser on a source of the given size   */
+/* in megabytes, with the scanner on the parser     */
+/* thread and then on a thread of its own, and      */
+/* parsing the source in pieces on 2 and 4 threads  */
+/* usage: pipe <megabytes>                          */
+/****************************************************/
+
+#include <time.h>
+#include "../globals.h"
+#include "../parse.h"
+#include "../compiler.h"
+
+static double now( void )
+{ struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* writeSource writes about mb megabytes of small
+   commented functions to f, returning their number */
+static long writeSource( FILE * f, int mb )
+{ long size = 0, funcs = 0;
+  while (size < mb * 1048576L)
+  { size += fprintf(f,"/* function %ld */\n",funcs);
+    size += fprintf(f,"int f%c%c%c(int a, int b[])\n",
+                    'a' + (int) (funcs / 676 % 26),'a' + (int) (funcs / 26 % 26),
+                    'a' + (int) (funcs % 26));
+    size += fprintf(f,"{ int index; int sum;\n  index = 0; sum = %ld;\n",funcs);
+    size += fprintf(f,"  while (index < a) { sum = sum + b[index] * index;"
+                      " index = index + 1; }\n");
+    size += fprintf(f,"  if (sum > 100) return sum / 2; else return sum - a;\n}\n");
+    funcs++;
+  }
+  return funcs;
+}
+
+/* parseSource parses source of the given size
+   and functions and reports the time taken */
+static void parseSource( FILE * source, const char * name, int mb,
+                         long bytes, long funcs )
+{ Compiler cc;
+  TreeNode * t;
+  double start, secs;
+  rewind(source);
+  cc = newCompiler(source,stdout);
+  start = now();
+  t = parseParallel(cc,ParseThreads);
+  secs = now() - start;
+  printf("%4d MB, %8ld functions, %-10s %.3f s, %6.1f MB/s\n",mb,funcs,
+         name,secs,bytes / 1048576.0 / secs);
+  if (cc->Error || (t == NULL)) printf("parse failed\n");
+  freeCompiler(cc);
+}
+
+int main( int argc, char * argv[] )
+{ FILE * source;
+  char name[32];
+  long funcs, bytes;
+  int mb;
+  if ((argc != 2) || ((mb = atoi(argv[1])) < 1))
+  { fprintf(stderr,"usage: %s <megabytes>\n",argv[0]);
+    exit(1);
+  }
+  source = tmpfile();
+  if (source == NULL)
+  { fprintf(stderr,"Unable to open a temporary file\n");
+    exit(1);
+  }
+  funcs = writeSource(source,mb);
+  bytes = ftell(source);
+  ParseThreads = 1;
+  for (PipelineScan = FALSE; PipelineScan <= TRUE; PipelineScan++)
+    parseSource(source,PipelineScan ? "pipeline:" : "single:",mb,bytes,funcs);
+  PipelineScan = FALSE;
+  for (ParseThreads = 2; ParseThreads <= 4; ParseThreads *= 2)
+  { sprintf(name,"%d pieces:",ParseThreads);
+    parseSource(source,name,mb,bytes,funcs);
+  }
+  fclose(source);
+  return 0;
+}
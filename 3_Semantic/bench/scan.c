@@ -0,0 +1,105 @@
+/****************************************************/
+/* File: bench/scan.c                               */
+/* Throughput benchmark for the C-MINUS scanner:    */
+/* scans a source of the given size in megabytes,   */
+/* with comment blocks, long names and very long    */
+/* lines, with the hand-coded and the table-driven  */
+/* cores, each on a source read in blocks and a     */
+/* mapped one, then with each slower path for runs  */
+/* of chars, and reports MB/s; built with -DFLEX,   */
+/* it times the flex scanner instead                */
+/* usage: scan <megabytes>                          */
+/****************************************************/
+
+#include <time.h>
+#include "../globals.h"
+#include "../scan.h"
+#include "../compiler.h"
+#include "../span.h"
+
+/* writeSource writes about mb megabytes of source
+   to f, returning the number of lines */
+static long writeSource( FILE * f, int mb )
+{ long size = 0, lines = 0;
+  int i;
+  while (size < mb * 1048576L)
+  { size += fprintf(f,"/* function %ld: sums the array\n"
+                      "   a of length n\n\n"
+                      "   the array is not changed; the sum may\n"
+                      "   overflow if the elements are large,\n"
+                      "   which is not checked */\n",lines);
+    size += fprintf(f,"int sum(int a[], int n)\n"
+                      "{ int index; int partialsumofthearray;\n"
+                      "  index = 0; partialsumofthearray = 0;\n"
+                      "  while (index < n) { partialsumofthearray ="
+                      " partialsumofthearray + a[index]; index = index + 1; }\n"
+                      "  return partialsumofthearray; }\n");
+    /* one line of some 2000 characters */
+    size += fprintf(f,"int x; x =");
+    for (i = 0; i < 100; i++) size += fprintf(f," x * %d +",i);
+    size += fprintf(f," 1;\n");
+    lines += 12;
+  }
+  return lines;
+}
+
+static const char * levelName[] = { "scalar", "sse2", "avx2" };
+
+/* scanSource scans source of the given size and
+   lines to its end and reports the time taken */
+static void scanSource( FILE * source, const char * name, int mb,
+                        long bytes, long lines )
+{ Compiler cc;
+  clock_t start;
+  long tokens;
+  double secs;
+  rewind(source);
+  cc = newCompiler(source,stdout);
+  start = clock();
+  for (tokens = 0; getToken(cc) != ENDFILE; tokens++) ;
+  secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+  printf("%4d MB %-22s %9ld tokens: %.3f s, %6.1f MB/s\n",mb,name,
+         tokens,secs,bytes / 1048576.0 / secs);
+  if (cc->lineno != lines + 1) printf("line count %d, expected %ld\n",
+                                     cc->lineno,lines + 1);
+  freeCompiler(cc);
+}
+
+int main( int argc, char * argv[] )
+{ FILE * source;
+  char name[32];
+  long lines, bytes;
+  int mb, level;
+  SpanLevel best = spanLevel;
+  BatchTokens = FALSE;
+  if ((argc != 2) || ((mb = atoi(argv[1])) < 1))
+  { fprintf(stderr,"usage: %s <megabytes>\n",argv[0]);
+    exit(1);
+  }
+  source = tmpfile();
+  if (source == NULL)
+  { fprintf(stderr,"Unable to open a temporary file\n");
+    exit(1);
+  }
+  lines = writeSource(source,mb);
+  bytes = ftell(source);
+#ifdef FLEX
+  scanSource(source,"flex,",mb,bytes,lines);
+#else
+  for (TableScan = FALSE; TableScan <= TRUE; TableScan++)
+    for (MapSource = FALSE; MapSource <= TRUE; MapSource++)
+    { sprintf(name,"%s %s %s,",TableScan ? "table" : "switch",
+              MapSource ? "mapped" : "blocks",levelName[best]);
+      scanSource(source,name,mb,bytes,lines);
+    }
+  for (level = best - 1; level >= SpanScalar; level--)
+    for (TableScan = FALSE; TableScan <= TRUE; TableScan++)
+    { spanLevel = (SpanLevel) level;
+      sprintf(name,"%s mapped %s,",TableScan ? "table" : "switch",
+              levelName[level]);
+      scanSource(source,name,mb,bytes,lines);
+    }
+#endif
+  fclose(source);
+  return 0;
+}
@@ -0,0 +1,53 @@
+/****************************************************/
+/* File: bench/scopes.c                             */
+/* Stress benchmark for the scope storage of the    */
+/* C-MINUS symbol table: builds 1M scopes, first    */
+/* side by side and then nested 1M deep             */
+/****************************************************/
+
+#include <time.h>
+#include "../globals.h"
+#include "../symtab.h"
+#include "../intern.h"
+#include "../compiler.h"
+
+#define NSCOPES 1000000
+
+static double seconds( clock_t start )
+{ return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main( void )
+{ Compiler cc = newCompiler(NULL,stdout);
+  char * name[4];
+  clock_t start;
+  int i, j;
+  name[0] = intern(cc,"main");
+  name[1] = intern(cc,"x");
+  name[2] = intern(cc,"y");
+  name[3] = intern(cc,"z");
+  sc_push(cc,sc_create(cc,intern(cc,"global")));
+
+  /* sibling blocks, each declaring a local */
+  start = clock();
+  for (i = 0; i < NSCOPES/2; i++)
+  { sc_push(cc,sc_create(cc,name[0]));
+    j = 1 + i % 3;
+    st_insert(cc,name[j],i,addLocation(cc,1),NULL);
+    sc_pop(cc);
+  }
+  printf("%d sibling scopes: %.3f s\n",NSCOPES/2,seconds(start));
+
+  /* one chain of nested blocks */
+  start = clock();
+  for (i = 0; i < NSCOPES/2; i++)
+  { sc_push(cc,sc_create(cc,name[0]));
+    j = 1 + i % 3;
+    st_insert(cc,name[j],i,addLocation(cc,1),NULL);
+  }
+  if (st_lookup(cc,name[1]) < 0) printf("lookup failed\n");
+  for (i = 0; i < NSCOPES/2; i++) sc_pop(cc);
+  printf("%d nested scopes:  %.3f s\n",NSCOPES/2,seconds(start));
+  freeCompiler(cc);
+  return 0;
+}
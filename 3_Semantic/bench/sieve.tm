@@ -0,0 +1,28 @@
+* Benchmark: sieve of Eratosthenes below 1000, repeated 1000 times
+* flags live in dMem[2..999]; prints the number of primes
+  0:    LDC  5,1000(0)   repetitions
+  1:    LDC  4,1000(0)   N
+  2:    LDC  6,1(0)      constant 1
+  3:    LDC  3,0(0)      count = 0
+  4:    LDC  1,2(0)      i = 2
+  5:     ST  3,0(1)      clear flag[i]
+  6:    ADD  1,1,6
+  7:    SUB  0,1,4
+  8:    JLT  0,-4(7)     while i < N
+  9:    LDC  1,2(0)      i = 2
+ 10:     LD  0,0(1)      flag[i]
+ 11:    JNE  0,7(7)      composite: next i
+ 12:    ADD  3,3,6       count++
+ 13:    MUL  2,1,1       j = i*i
+ 14:    SUB  0,2,4
+ 15:    JGE  0,3(7)      j >= N: next i
+ 16:     ST  6,0(2)      flag[j] = 1
+ 17:    ADD  2,2,1       j += i
+ 18:    LDA  7,-5(7)     loop on j
+ 19:    ADD  1,1,6       next i
+ 20:    SUB  0,1,4
+ 21:    JLT  0,-12(7)    while i < N
+ 22:    SUB  5,5,6
+ 23:    JGT  5,-21(7)    repeat
+ 24:    OUT  3,0,0       print count
+ 25:   HALT  0,0,0
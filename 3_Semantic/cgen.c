@@ -1,7 +1,7 @@
 /****************************************************/
 /* File: cgen.c                                     */
 /* The code generator implementation                */
-/* for the TINY compiler                            */
+/* for the C-MINUS compiler                         */
 /* (generates code for the TM machine)              */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
@@ -11,176 +11,471 @@
 #include "symtab.h"
 #include "code.h"
 #include "cgen.h"
+#include "intern.h"
+#include "arena.h"
 
-/* tmpOffset is the memory offset for temps
-   It is decremented each time a temp is
-   stored, and incremeted when loaded again
-*/
-static int tmpOffset = 0;
+/* Activation records. fp points to the frame
+ * of the running function:
+ *     0(fp)         old fp
+ *    -1(fp)         return address
+ *    -2-loc(fp)     parameter or local variable with
+ *                   memory location loc; an array of
+ *                   size n starts at -2-loc-(n-1)(fp)
+ * Globals live at loc(gp), and gp stays 0.
+ * mp points just below the locals of the frame;
+ * temporaries and the frames of calls go below it.
+ */
+
+/* registers regBase .. regBase+NREGS-1 hold
+   expression temporaries; ac1 is the scratch
+   register for an operand reloaded from memory */
+#define regBase 2
+#define NREGS 2
+
+/* the entry locations of the functions
+   generated so far */
+typedef struct FuncRec
+{ TreeNode * decl;
+  int entry;
+  struct FuncRec * next;
+} * FuncList;
+
+/* the state of the code generator for
+   a compilation */
+typedef struct CGenRec
+{ /* tmpOffset is the memory offset for temps
+     It is decremented each time a temp is
+     stored, and incremeted when loaded again;
+     genReg only stores a temp when the
+     temporary registers run out
+  */
+  int tmpOffset;
+
+  /* locations used by the locals of the function
+     being generated */
+  int frameSize;
+
+  FuncList funcs;
+} * CGen;
+
+/* cgenOf returns the code generator state of cc,
+   creating it on first use */
+static CGen cgenOf( Compiler cc )
+{ if (cc->cgen == NULL)
+  { cc->cgen = (CGen) calloc(1,sizeof(struct CGenRec));
+    if (cc->cgen == NULL)
+    { fprintf(cc->listing,"Out of memory error in code generation\n");
+      exit(1);
+    }
+  }
+  return cc->cgen;
+}
+
+/* Procedure cgenFree releases the code generator
+   state of cc; the function list lives in its arena */
+void cgenFree( Compiler cc )
+{ free(cc->cgen);
+  cc->cgen = NULL;
+}
 
 /* prototype for internal recursive code generator */
-static void cGen (TreeNode * tree);
+static void cGen( Compiler cc, TreeNode * tree);
+
+static void genReg( Compiler cc, TreeNode * tree, int dst, int free);
+
+/* Function funcEntry returns the entry location
+ * of function name (interned), -1 if not generated yet
+ */
+static int funcEntry( Compiler cc, char * name)
+{ CGen g = cgenOf(cc);
+  FuncList f;
+  for (f = g->funcs; f != NULL; f = f->next)
+    if (f->decl->attr.name == name) return f->entry;
+  return -1;
+}
+
+/* Function isArray is TRUE if decl declares
+ * an array variable or parameter
+ */
+static int isArray( TreeNode * decl)
+{ if (decl->nodekind == DeclK) return decl->kind.decl == ArrVarK;
+  if (decl->nodekind == ParamK) return decl->kind.param == ArrParamK;
+  return FALSE;
+}
+
+/* Function varOffset returns the offset of variable
+ * name from its base register, which it stores in
+ * base; for an array the offset is of element 0
+ */
+static int varOffset( Compiler cc, char * name, int * base)
+{ BucketList l = get_bucket(cc,name);
+  if (get_bucket_scope(cc,name)->nestedLevel == 0)
+  { *base = gp;
+    return l->memloc;
+  }
+  *base = fp;
+  if ((l->treeNode->nodekind == DeclK) && (l->treeNode->kind.decl == ArrVarK))
+    return -2 - l->memloc - (l->treeNode->attr.arr.size-1);
+  return -2 - l->memloc;
+}
+
+/* Function regNeed returns the Sethi-Ullman number
+ * of an expression: the registers needed to evaluate
+ * it without storing temporaries
+ */
+static int regNeed( TreeNode * tree)
+{ int l, r;
+  switch (tree->kind.exp) {
+    case OpK :
+      l = regNeed(tree->child[0]);
+      r = regNeed(tree->child[1]);
+      if (l == r) return l + 1;
+      return l > r ? l : r;
+    case ArrIdK :
+      return regNeed(tree->child[0]);
+    case AssignK :
+      l = regNeed(tree->child[1]);
+      if (tree->child[0]->kind.exp != ArrIdK) return l;
+      r = regNeed(tree->child[0]) + 1;
+      return l > r ? l : r;
+    case CallK :
+      /* a call saves the registers in use, so it
+         is best evaluated first */
+      return NREGS + 1;
+    default:
+      return 1;
+  }
+}
+
+/* Procedure genOp emits dst = a op b */
+static void genOp( Compiler cc, TokenType op, int dst, int a, int b)
+{ char * jmp;
+  switch (op) {
+    case PLUS :
+      emitRO(cc,"ADD",dst,a,b,"op +");
+      return;
+    case MINUS :
+      emitRO(cc,"SUB",dst,a,b,"op -");
+      return;
+    case TIMES :
+      emitRO(cc,"MUL",dst,a,b,"op *");
+      return;
+    case OVER :
+      emitRO(cc,"DIV",dst,a,b,"op /");
+      return;
+    case LT : jmp = "JLT"; break;
+    case LE : jmp = "JLE"; break;
+    case GT : jmp = "JGT"; break;
+    case GE : jmp = "JGE"; break;
+    case EQ : jmp = "JEQ"; break;
+    case NE : jmp = "JNE"; break;
+    default:
+      emitComment(cc,"BUG: Unknown operator");
+      return;
+  }
+  emitRO(cc,"SUB",dst,a,b,"op: compare") ;
+  emitRM(cc,jmp,dst,2,pc,"br if true") ;
+  emitRM(cc,"LDC",dst,0,dst,"false case") ;
+  emitRM(cc,"LDA",pc,1,pc,"unconditional jmp") ;
+  emitRM(cc,"LDC",dst,1,dst,"true case") ;
+} /* genOp */
+
+/* Function genElement generates code for the index
+ * of array element tree into register r and adds
+ * the base of the array; it returns the offset of
+ * the element from r
+ */
+static int genElement( Compiler cc, TreeNode * tree, int r, int free)
+{ BucketList l = get_bucket(cc,tree->attr.name);
+  int base, off;
+  genReg(cc,tree->child[0],r,free);
+  off = varOffset(cc,tree->attr.name,&base);
+  if (l->treeNode->nodekind == ParamK)
+  { /* the parameter holds the address of element 0 */
+    emitRM(cc,"LD",ac1,off,fp,"load array address");
+    emitRO(cc,"ADD",r,r,ac1,"add array address");
+    return 0;
+  }
+  if (base != gp) emitRO(cc,"ADD",r,r,base,"add frame pointer");
+  return off;
+} /* genElement */
+
+/* Procedure genCall generates code for call tree
+ * with the result in register dst; the registers
+ * below regBase+free are saved around the call
+ */
+static void genCall( Compiler cc, TreeNode * tree, int dst, int free)
+{ CGen g = cgenOf(cc);
+  TreeNode * arg;
+  int i, n, base, entry, saved;
+  if (tree->attr.name == intern(cc,"input"))
+  { emitRO(cc,"IN",dst,0,0,"read integer value");
+    return;
+  }
+  if (tree->attr.name == intern(cc,"output"))
+  { genReg(cc,tree->child[0],ac,free);
+    emitRO(cc,"OUT",ac,0,0,"write ac");
+    return;
+  }
+  if (TraceCode) emitComment(cc,"-> call") ;
+  saved = free < NREGS ? free : NREGS;
+  for (i = 0; i < saved; i++)
+    emitRM(cc,"ST",regBase+i,g->tmpOffset--,mp,"call: save register");
+  /* the frame of the callee starts at the next temp */
+  base = g->tmpOffset;
+  n = 0;
+  for (arg = tree->child[0]; arg != NULL; arg = arg->sibling) n++;
+  g->tmpOffset = base - 2 - n;
+  for (arg = tree->child[0], i = 0; arg != NULL; arg = arg->sibling, i++)
+  { genReg(cc,arg,ac,0);
+    emitRM(cc,"ST",ac,base-2-i,mp,"call: store argument");
+  }
+  emitRM(cc,"ST",fp,base,mp,"call: store old fp");
+  emitRM(cc,"LDA",fp,base,mp,"call: push frame");
+  emitRM(cc,"LDA",ac,1,pc,"call: return address");
+  entry = funcEntry(cc,tree->attr.name);
+  if (entry < 0) emitComment(cc,"BUG: call of an unknown function");
+  emitRM_Abs(cc,"LDA",pc,entry,"call: jump to function");
+  emitRM(cc,"LDA",mp,-2-g->frameSize,fp,"call: restore mp");
+  g->tmpOffset = base;
+  for (i = saved-1; i >= 0; i--)
+    emitRM(cc,"LD",regBase+i,++g->tmpOffset,mp,"call: restore register");
+  if (dst != ac) emitRM(cc,"LDA",dst,0,ac,"call: move result");
+  if (TraceCode) emitComment(cc,"<- call") ;
+} /* genCall */
+
+/* Procedure genAssign generates code for
+ * assignment tree with the value assigned
+ * in register dst
+ */
+static void genAssign( Compiler cc, TreeNode * tree, int dst, int free)
+{ CGen g = cgenOf(cc);
+  TreeNode * var = tree->child[0];
+  int base, off, f, r;
+  if (TraceCode) emitComment(cc,"-> assign") ;
+  if (var->kind.exp != ArrIdK)
+  { genReg(cc,tree->child[1],dst,free);
+    off = varOffset(cc,var->attr.name,&base);
+    emitRM(cc,"ST",dst,off,base,"assign: store value");
+  }
+  else
+  { f = (dst == regBase+free) ? free+1 : free;
+    if (f < NREGS)
+    { r = regBase + f;
+      off = genElement(cc,var,r,f);
+      genReg(cc,tree->child[1],dst,f+1);
+      emitRM(cc,"ST",dst,off,r,"assign: store element");
+    }
+    else
+    { /* out of registers: keep the address in memory */
+      off = genElement(cc,var,dst,free);
+      emitRM(cc,"LDA",dst,off,dst,"assign: element address");
+      emitRM(cc,"ST",dst,g->tmpOffset--,mp,"assign: push address");
+      genReg(cc,tree->child[1],dst,free);
+      emitRM(cc,"LD",ac1,++g->tmpOffset,mp,"assign: load address");
+      emitRM(cc,"ST",dst,0,ac1,"assign: store element");
+    }
+  }
+  if (TraceCode)  emitComment(cc,"<- assign") ;
+} /* genAssign */
+
+/* Procedure genReg generates code for the value
+ * of an expression into register dst, with the
+ * temporary registers from regBase+free on
+ * still unused; dst may be one of them
+ */
+static void genReg( Compiler cc, TreeNode * tree, int dst, int free)
+{ CGen g = cgenOf(cc);
+  TreeNode * p1, * p2, * first, * second;
+  BucketList l;
+  int base, off, f, h;
+  switch (tree->kind.exp) {
+
+    case ConstK :
+      emitRM(cc,"LDC",dst,tree->attr.val,0,"load const");
+      break; /* ConstK */
+
+    case IdK :
+      l = get_bucket(cc,tree->attr.name);
+      off = varOffset(cc,tree->attr.name,&base);
+      if (!isArray(l->treeNode))
+        emitRM(cc,"LD",dst,off,base,"load id value");
+      else if (l->treeNode->nodekind == ParamK)
+        emitRM(cc,"LD",dst,off,base,"load array address");
+      else
+        emitRM(cc,"LDA",dst,off,base,"load array address");
+      break; /* IdK */
+
+    case ArrIdK :
+      off = genElement(cc,tree,dst,free);
+      emitRM(cc,"LD",dst,off,dst,"load array element");
+      break; /* ArrIdK */
+
+    case AssignK :
+      genAssign(cc,tree,dst,free);
+      break; /* AssignK */
+
+    case CallK :
+      genCall(cc,tree,dst,free);
+      break; /* CallK */
+
+    case OpK :
+      if (TraceCode) emitComment(cc,"-> Op") ;
+      p1 = tree->child[0];
+      p2 = tree->child[1];
+      /* evaluate the operand needing more registers first */
+      if (regNeed(p1) >= regNeed(p2))
+      { first = p1; second = p2; }
+      else
+      { first = p2; second = p1; }
+      f = (dst == regBase+free) ? free+1 : free;
+      if (f < NREGS)
+      { h = regBase + f;
+        genReg(cc,first,h,f);
+        genReg(cc,second,dst,f+1);
+      }
+      else
+      { /* out of registers: keep the first operand in memory */
+        genReg(cc,first,dst,free);
+        emitRM(cc,"ST",dst,g->tmpOffset--,mp,"op: push operand");
+        genReg(cc,second,dst,free);
+        emitRM(cc,"LD",ac1,++g->tmpOffset,mp,"op: load operand");
+        h = ac1;
+      }
+      if (first == p1) genOp(cc,tree->attr.op,dst,h,dst);
+      else genOp(cc,tree->attr.op,dst,dst,h);
+      if (TraceCode)  emitComment(cc,"<- Op") ;
+      break; /* OpK */
+
+    default:
+      break;
+  }
+} /* genReg */
+
+/* Procedure genReturn generates code to return
+ * from the function being generated
+ */
+static void genReturn( Compiler cc )
+{ emitRM(cc,"LD",ac1,-1,fp,"return: load return address");
+  emitRM(cc,"LD",fp,0,fp,"return: restore old fp");
+  emitRM(cc,"LDA",pc,0,ac1,"return: jump back");
+}
 
 /* Procedure genStmt generates code at a statement node */
-static void genStmt( TreeNode * tree)
+static void genStmt( Compiler cc, TreeNode * tree)
 { TreeNode * p1, * p2, * p3;
-  int savedLoc1,savedLoc2,currentLoc;
-  int loc;
+  int savedLoc1,savedLoc2 = 0,currentLoc;
   switch (tree->kind.stmt) {
 
+      case CompK :
+         sc_push(cc,tree->attr.scope);
+         cGen(cc,tree->child[1]);
+         sc_pop(cc);
+         break; /* CompK */
+
       case IfK :
-         if (TraceCode) emitComment("-> if") ;
+      case IfEK :
+         if (TraceCode) emitComment(cc,"-> if") ;
          p1 = tree->child[0] ;
          p2 = tree->child[1] ;
          p3 = tree->child[2] ;
          /* generate code for test expression */
-         cGen(p1);
-         savedLoc1 = emitSkip(1) ;
-         emitComment("if: jump to else belongs here");
+         genReg(cc,p1,ac,0);
+         savedLoc1 = emitSkip(cc,1) ;
+         emitComment(cc,"if: jump to else belongs here");
          /* recurse on then part */
-         cGen(p2);
-         savedLoc2 = emitSkip(1) ;
-         emitComment("if: jump to end belongs here");
-         currentLoc = emitSkip(0) ;
-         emitBackup(savedLoc1) ;
-         emitRM_Abs("JEQ",ac,currentLoc,"if: jmp to else");
-         emitRestore() ;
-         /* recurse on else part */
-         cGen(p3);
-         currentLoc = emitSkip(0) ;
-         emitBackup(savedLoc2) ;
-         emitRM_Abs("LDA",pc,currentLoc,"jmp to end") ;
-         emitRestore() ;
-         if (TraceCode)  emitComment("<- if") ;
+         cGen(cc,p2);
+         /* an empty else part needs no jump over it */
+         if (p3 != NULL)
+         { savedLoc2 = emitSkip(cc,1) ;
+           emitComment(cc,"if: jump to end belongs here");
+         }
+         currentLoc = emitSkip(cc,0) ;
+         emitBackup(cc,savedLoc1) ;
+         emitRM_Abs(cc,"JEQ",ac,currentLoc,"if: jmp to else");
+         emitRestore(cc) ;
+         if (p3 != NULL)
+         { /* recurse on else part */
+           cGen(cc,p3);
+           currentLoc = emitSkip(cc,0) ;
+           emitBackup(cc,savedLoc2) ;
+           emitRM_Abs(cc,"LDA",pc,currentLoc,"jmp to end") ;
+           emitRestore(cc) ;
+         }
+         if (TraceCode)  emitComment(cc,"<- if") ;
          break; /* if_k */
 
-      case RepeatK:
-         if (TraceCode) emitComment("-> repeat") ;
+      case IterK :
+         if (TraceCode) emitComment(cc,"-> while") ;
          p1 = tree->child[0] ;
          p2 = tree->child[1] ;
-         savedLoc1 = emitSkip(0);
-         emitComment("repeat: jump after body comes back here");
-         /* generate code for body */
-         cGen(p1);
-         /* generate code for test */
-         cGen(p2);
-         emitRM_Abs("JEQ",ac,savedLoc1,"repeat: jmp back to body");
-         if (TraceCode)  emitComment("<- repeat") ;
-         break; /* repeat */
-
-      case AssignK:
-         if (TraceCode) emitComment("-> assign") ;
-         /* generate code for rhs */
-         cGen(tree->child[0]);
-         /* now store value */
-         loc = st_lookup(tree->attr.name);
-         emitRM("ST",ac,loc,gp,"assign: store value");
-         if (TraceCode)  emitComment("<- assign") ;
-         break; /* assign_k */
-
-      case ReadK:
-         emitRO("IN",ac,0,0,"read integer value");
-         loc = st_lookup(tree->attr.name);
-         emitRM("ST",ac,loc,gp,"read: store value");
-         break;
-      case WriteK:
-         /* generate code for expression to write */
-         cGen(tree->child[0]);
-         /* now output it */
-         emitRO("OUT",ac,0,0,"write ac");
-         break;
+         /* the test follows the body, so each
+            iteration takes one jump */
+         savedLoc1 = emitSkip(cc,1) ;
+         emitComment(cc,"while: jump to test belongs here");
+         savedLoc2 = emitSkip(cc,0) ;
+         cGen(cc,p2);
+         currentLoc = emitSkip(cc,0) ;
+         emitBackup(cc,savedLoc1) ;
+         emitRM_Abs(cc,"LDA",pc,currentLoc,"while: jmp to test");
+         emitRestore(cc) ;
+         genReg(cc,p1,ac,0);
+         emitRM_Abs(cc,"JNE",ac,savedLoc2,"while: jmp back to body");
+         if (TraceCode)  emitComment(cc,"<- while") ;
+         break; /* IterK */
+
+      case RetK :
+         if (TraceCode) emitComment(cc,"-> return") ;
+         if (tree->child[0] != NULL) genReg(cc,tree->child[0],ac,0);
+         genReturn(cc);
+         if (TraceCode)  emitComment(cc,"<- return") ;
+         break; /* RetK */
+
       default:
          break;
     }
 } /* genStmt */
 
-/* Procedure genExp generates code at an expression node */
-static void genExp( TreeNode * tree)
-{ int loc;
-  TreeNode * p1, * p2;
-  switch (tree->kind.exp) {
-
-    case ConstK :
-      if (TraceCode) emitComment("-> Const") ;
-      /* gen code to load integer constant using LDC */
-      emitRM("LDC",ac,tree->attr.val,0,"load const");
-      if (TraceCode)  emitComment("<- Const") ;
-      break; /* ConstK */
-    
-    case IdK :
-      if (TraceCode) emitComment("-> Id") ;
-      loc = st_lookup(tree->attr.name);
-      emitRM("LD",ac,loc,gp,"load id value");
-      if (TraceCode)  emitComment("<- Id") ;
-      break; /* IdK */
-
-    case OpK :
-         if (TraceCode) emitComment("-> Op") ;
-         p1 = tree->child[0];
-         p2 = tree->child[1];
-         /* gen code for ac = left arg */
-         cGen(p1);
-         /* gen code to push left operand */
-         emitRM("ST",ac,tmpOffset--,mp,"op: push left");
-         /* gen code for ac = right operand */
-         cGen(p2);
-         /* now load left operand */
-         emitRM("LD",ac1,++tmpOffset,mp,"op: load left");
-         switch (tree->attr.op) {
-            case PLUS :
-               emitRO("ADD",ac,ac1,ac,"op +");
-               break;
-            case MINUS :
-               emitRO("SUB",ac,ac1,ac,"op -");
-               break;
-            case TIMES :
-               emitRO("MUL",ac,ac1,ac,"op *");
-               break;
-            case OVER :
-               emitRO("DIV",ac,ac1,ac,"op /");
-               break;
-            case LT :
-               emitRO("SUB",ac,ac1,ac,"op <") ;
-               emitRM("JLT",ac,2,pc,"br if true") ;
-               emitRM("LDC",ac,0,ac,"false case") ;
-               emitRM("LDA",pc,1,pc,"unconditional jmp") ;
-               emitRM("LDC",ac,1,ac,"true case") ;
-               break;
-            case EQ :
-               emitRO("SUB",ac,ac1,ac,"op ==") ;
-               emitRM("JEQ",ac,2,pc,"br if true");
-               emitRM("LDC",ac,0,ac,"false case") ;
-               emitRM("LDA",pc,1,pc,"unconditional jmp") ;
-               emitRM("LDC",ac,1,ac,"true case") ;
-               break;
-            default:
-               emitComment("BUG: Unknown operator");
-               break;
-         } /* case op */
-         if (TraceCode)  emitComment("<- Op") ;
-         break; /* OpK */
-
-    default:
-      break;
-  }
-} /* genExp */
+/* Procedure genFunc generates code for
+ * function declaration tree
+ */
+static void genFunc( Compiler cc, TreeNode * tree)
+{ CGen g = cgenOf(cc);
+  FuncList f = (FuncList) arenaAlloc(cc,sizeof(struct FuncRec),ArenaOther);
+  if (TraceCode) emitComment(cc,"-> function") ;
+  emitComment(cc,tree->attr.name);
+  f->decl = tree;
+  f->entry = emitSkip(cc,0);
+  f->next = g->funcs;
+  g->funcs = f;
+  g->frameSize = tree->child[2]->attr.scope->frameSize;
+  g->tmpOffset = 0;
+  emitRM(cc,"ST",ac,-1,fp,"function: store return address");
+  emitRM(cc,"LDA",mp,-2-g->frameSize,fp,"function: set mp");
+  cGen(cc,tree->child[2]);
+  genReturn(cc);
+  if (TraceCode)  emitComment(cc,"<- function") ;
+} /* genFunc */
 
 /* Procedure cGen recursively generates code by
  * tree traversal
  */
-static void cGen( TreeNode * tree)
-{ if (tree != NULL)
+static void cGen( Compiler cc, TreeNode * tree)
+{ while (tree != NULL)
   { switch (tree->nodekind) {
       case StmtK:
-        genStmt(tree);
+        genStmt(cc,tree);
         break;
       case ExpK:
-        genExp(tree);
+        genReg(cc,tree,ac,0);
+        break;
+      case DeclK:
+        if (tree->kind.decl == FuncK) genFunc(cc,tree);
         break;
       default:
         break;
     }
-    cGen(tree->sibling);
+    tree = tree->sibling;
   }
 }
 
@@ -191,22 +486,32 @@ static void cGen( TreeNode * tree)
  * file by traversal of the syntax tree. The
  * second parameter (codefile) is the file name
  * of the code file, and is used to print the
- * file name as a comment in the code file
+ * file name as a comment in the code file; the
+ * code goes to cc->code
  */
-void codeGen(TreeNode * syntaxTree, char * codefile)
+void codeGen(Compiler cc, TreeNode * syntaxTree, char * codefile)
 {  char * s = malloc(strlen(codefile)+7);
+   int mainLoc, entry;
    strcpy(s,"File: ");
    strcat(s,codefile);
-   emitComment("TINY Compilation to TM Code");
-   emitComment(s);
+   emitComment(cc,"C-MINUS Compilation to TM Code");
+   emitComment(cc,s);
    /* generate standard prelude */
-   emitComment("Standard prelude:");
-   emitRM("LD",mp,0,ac,"load maxaddress from location 0");
-   emitRM("ST",ac,0,ac,"clear location 0");
-   emitComment("End of standard prelude.");
-   /* generate code for TINY program */
-   cGen(syntaxTree);
-   /* finish */
-   emitComment("End of execution.");
-   emitRO("HALT",0,0,0,"");
+   emitComment(cc,"Standard prelude:");
+   emitRM(cc,"LD",mp,0,ac,"load maxaddress from location 0");
+   emitRM(cc,"ST",ac,0,ac,"clear location 0");
+   emitRM(cc,"LDA",fp,0,mp,"frame of main at top of memory");
+   emitRM(cc,"LDA",ac,1,pc,"call main: return address");
+   mainLoc = emitSkip(cc,1);
+   emitRO(cc,"HALT",0,0,0,"");
+   emitComment(cc,"End of standard prelude.");
+   /* generate code for C-MINUS program */
+   cGen(cc,syntaxTree);
+   entry = funcEntry(cc,intern(cc,"main"));
+   emitBackup(cc,mainLoc);
+   if (entry >= 0) emitRM_Abs(cc,"LDA",pc,entry,"call main");
+   else emitRO(cc,"HALT",0,0,0,"no main function");
+   emitRestore(cc);
+   emitFinish(cc);
+   free(s);
 }
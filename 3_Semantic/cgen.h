@@ -12,8 +12,14 @@
  * file by traversal of the syntax tree. The
  * second parameter (codefile) is the file name
  * of the code file, and is used to print the
- * file name as a comment in the code file
+ * file name as a comment in the code file; the
+ * code goes to cc->code
  */
-void codeGen(TreeNode * syntaxTree, char * codefile);
+void codeGen(Compiler cc, TreeNode * syntaxTree, char * codefile);
+
+/* Procedure cgenFree releases the code generator
+ * state of cc
+ */
+void cgenFree(Compiler cc);
 
 #endif
@@ -12,13 +12,29 @@
 #include "scan.h"
 #include "parse.h"
 
-#define YYSTYPE TreeNode *
-static char * savedName; /* for use in assignments */
-static int savedNumber;
-static int savedLineNo;  /* ditto */
-static TreeNode * savedTree; /* stores syntax tree for later return */
-static int yylex(void); // added 11/2/11 to ensure no conflict with lex
+/* the parser is reentrant: the values it saves
+ * for later actions live in the context cc
+ */
+%}
+
+%define api.pure full
+%parse-param { Compiler cc }
+%lex-param { Compiler cc }
+
+/* a list carries its last node as well, so that
+ * the left-recursive list rules append in
+ * constant time
+ */
+%union { struct treeNode * node;
+         struct treeList
+         { struct treeNode * head;
+           struct treeNode * tail;
+         } list;
+       }
 
+%{
+static int yylex(YYSTYPE * lvalp, Compiler cc);
+int yyerror(Compiler cc, char * message);
 %}
 
 /* reserved words */
@@ -33,125 +49,120 @@ static int yylex(void); // added 11/2/11 to ensure no conflict with lex
 %nonassoc NO_ELSE
 %nonassoc ELSE
 
+%type <list> decl_list param_list local_decls stmt_list arg_list
+%type <node> decl var_decl type_spec fun_decl params param comp_stmt
+%type <node> stmt exp_stmt sel_stmt iter_stmt ret_stmt
+%type <node> exp var simple_exp add_exp term factor call args
+
 %% /* Grammar for TINY */
 
 program     : decl_list
-                 { savedTree = $1;} 
+                 { cc->savedTree = $1.head;} 
             ;
 decl_list   : decl_list decl
-                 { YYSTYPE t = $1;
-                   if (t != NULL)
-                   { while (t->sibling != NULL)
-                        t = t->sibling;
-                     t->sibling = $2;
-                     $$ = $1; }
-                     else $$ = $2;
-                 }
-            | decl  { $$ = $1; }
+                 { $$ = $1;
+                   $$.tail->sibling = $2;
+                   $$.tail = $2;
+                 }
+            | decl  { $$.head = $$.tail = $1; }
             ;
 decl        : var_decl  { $$ = $1; }
             | fun_decl { $$ = $1; }
             ;
 saveName    : ID
-                 { savedName = copyString(tokenString);
-                   savedLineNo = lineno;
+                 { cc->savedName = lexemeName(cc);
+                   cc->savedLineNo = cc->lineno;
                  }
             ;
 saveNumber  : NUM
-                 { savedNumber = atoi(tokenString);
-                   savedLineNo = lineno;
+                 { cc->savedNumber = lexemeNumber(cc);
+                   cc->savedLineNo = cc->lineno;
                  }
             ;
 var_decl    : type_spec saveName SEMI
-                 { $$ = newDeclNode(VarK);
+                 { $$ = newDeclNode(cc,VarK);
                    $$->child[0] = $1;
-                   $$->lineno = lineno;
-                   $$->attr.name = savedName;
+                   $$->lineno = cc->lineno;
+                   $$->attr.name = cc->savedName;
                  }
             | type_spec saveName LBRACE saveNumber RBRACE SEMI
-                 { $$ = newDeclNode(ArrVarK);
+                 { $$ = newDeclNode(cc,ArrVarK);
                    $$->child[0] = $1;
-                   $$->lineno = lineno;
-                   $$->attr.arr.name = savedName;
-                   $$->attr.arr.size = savedNumber;
+                   $$->lineno = cc->lineno;
+                   $$->attr.arr.name = cc->savedName;
+                   $$->attr.arr.size = cc->savedNumber;
                  }
             ;            
 type_spec   : INT
-                 { $$ = newTypeNode(TypeNameK);
+                 { $$ = newTypeNode(cc,TypeNameK);
                    $$->attr.type = INT;
                  }
             | VOID
-                 { $$ = newTypeNode(TypeNameK);
+                 { $$ = newTypeNode(cc,TypeNameK);
                    $$->attr.type = VOID;
                  }
             ;
 fun_decl    : type_spec saveName 
-                 { $$ = newDeclNode(FuncK);
-                   $$->lineno = lineno;
-                   $$->attr.name = savedName;
+                 { $<node>$ = newDeclNode(cc,FuncK);
+                   $<node>$->lineno = cc->lineno;
+                   $<node>$->attr.name = cc->savedName;
                  }
               LPAREN params RPAREN comp_stmt
-                 { $$ = $3;
+                 { $$ = $<node>3;
                    $$->child[0] = $1;
                    $$->child[1] = $5;
                    $$->child[2] = $7;
                  }
             ;
-params      : param_list  { $$ = $1; }
+params      : param_list  { $$ = $1.head; }
             | type_spec
-                 { $$ = newParamNode(NonArrParamK);
+                 { $$ = newParamNode(cc,NonArrParamK);
                    $$->child[0] = $1;
-                   $$->attr.name = copyString("(null)");
+                   $$->attr.name = copyString(cc,"(null)");
                  }
             ;
 param_list  : param_list COMMA param
-                 { YYSTYPE t = $1;
-                   if(t != NULL)
-                   { while (t->sibling != NULL)
-                        t = t->sibling;
-                     t->sibling = $3;
-                     $$ = $1; }
-                     else $$ = $3;
-                 }
-            | param { $$ = $1; }
+                 { $$ = $1;
+                   $$.tail->sibling = $3;
+                   $$.tail = $3;
+                 }
+            | param { $$.head = $$.tail = $1; }
 param       : type_spec saveName
-                 { $$ = newParamNode(NonArrParamK);
+                 { $$ = newParamNode(cc,NonArrParamK);
                    $$->child[0] = $1;
-                   $$->attr.name = savedName;
+                   $$->attr.name = cc->savedName;
                  }
             | type_spec saveName LBRACE RBRACE
-                 { $$ = newParamNode(ArrParamK);
+                 { $$ = newParamNode(cc,ArrParamK);
                    $$->child[0] = $1;
-                   $$->attr.name = savedName;
+                   $$->attr.name = cc->savedName;
                  }
             ;
 comp_stmt   : LCURLY local_decls stmt_list RCURLY
-                 { $$ = newStmtNode(CompK);
-                   $$->child[0] = $2;
-                   $$->child[1] = $3;
+                 { $$ = newStmtNode(cc,CompK);
+                   $$->child[0] = $2.head;
+                   $$->child[1] = $3.head;
                  }
             ;
 local_decls : local_decls var_decl
-                 { YYSTYPE t = $1;
-                   if(t != NULL)
-                   { while (t->sibling != NULL)
-                        t = t->sibling;
-                     t->sibling = $2;
-                     $$ = $1; }
-                     else $$ = $2;
-                 }
-            | { $$ = NULL; }
+                 { $$ = $1;
+                   if ($2 != NULL)
+                   { if ($$.head == NULL) $$.head = $2;
+                     else $$.tail->sibling = $2;
+                     $$.tail = $2;
+                   }
+                 }
+            | { $$.head = $$.tail = NULL; }
             ;
 stmt_list   : stmt_list stmt
-                 { YYSTYPE t = $1;
-                   if(t != NULL)
-                   { while (t->sibling != NULL)
-                        t = t->sibling;
-                     t->sibling = $2;
-                     $$ = $1; }
-                     else $$ = $2;
-                 }
-            | { $$ = NULL; }
+                 { $$ = $1;
+                   if ($2 != NULL)
+                   { if ($$.head == NULL) $$.head = $2;
+                     else $$.tail->sibling = $2;
+                     $$.tail = $2;
+                   }
+                 }
+            | { $$.head = $$.tail = NULL; }
             ;
 stmt        : exp_stmt { $$ = $1; }
             | comp_stmt { $$ = $1; }
@@ -163,85 +174,85 @@ exp_stmt    : exp SEMI  { $$= $1; }
             | SEMI  { $$ = NULL; }
             ;
 sel_stmt    : IF LPAREN exp RPAREN stmt %prec NO_ELSE
-                 { $$ = newStmtNode(IfK);
+                 { $$ = newStmtNode(cc,IfK);
                    $$->child[0] = $3;
                    $$->child[1] = $5;
                    $$->child[2] = NULL;
                  }
             | IF LPAREN exp RPAREN stmt ELSE stmt
-                 { $$ = newStmtNode(IfEK);
+                 { $$ = newStmtNode(cc,IfEK);
                    $$->child[0] = $3;
                    $$->child[1] = $5;
                    $$->child[2] = $7;
                  }
             ;
 iter_stmt   : WHILE LPAREN exp RPAREN stmt
-                 { $$ = newStmtNode(IterK);
+                 { $$ = newStmtNode(cc,IterK);
                    $$->child[0] = $3;
                    $$->child[1] = $5;
                  }
             ;
 ret_stmt    : RETURN SEMI
-                 { $$ = newStmtNode(RetK);
+                 { $$ = newStmtNode(cc,RetK);
                    $$->child[0] = NULL;
                  }
             | RETURN exp SEMI
-                 { $$ = newStmtNode(RetK);
+                 { $$ = newStmtNode(cc,RetK);
                    $$->child[0] = $2;
                  }
             ;
 exp         : var ASSIGN exp
-                 { $$ = newExpNode(AssignK);
+                 { $$ = newExpNode(cc,AssignK);
                    $$->child[0] = $1;
                    $$->child[1] = $3;
                  }
             | simple_exp { $$ = $1; }
             ;
 var         : saveName
-                 { $$ = newExpNode(IdK);
-                   $$->attr.name = savedName;
+                 { $$ = newExpNode(cc,IdK);
+                   $$->attr.name = cc->savedName;
                  }
             | saveName
-                 { $$ = newExpNode(ArrIdK);
-                   $$->attr.name = savedName;
+                 { $<node>$ = newExpNode(cc,ArrIdK);
+                   $<node>$->attr.name = cc->savedName;
                  }
               LBRACE exp RBRACE
-                 { $$ = $2;
+                 { $$ = $<node>2;
                    $$->child[0] = $4;
                  }
             ;
 simple_exp  : add_exp LE add_exp
-                 { $$ = newExpNode(OpK);
+                 { $$ = newExpNode(cc,OpK);
                    $$->child[0] = $1;
                    $$->child[1] = $3;
                    $$->attr.op = LE;
                  }
             | add_exp LT add_exp
-                 { $$ = newExpNode(OpK);
+                 { $$ = newExpNode(cc,OpK);
                    $$->child[0] = $1;
                    $$->child[1] = $3;
                    $$->attr.op = LT;
                  }
             | add_exp GT add_exp
-                 { $$ = newExpNode(OpK);
+                 { $$ = newExpNode(cc,OpK);
                    $$->child[0] = $1;
                    $$->child[1] = $3;
                    $$->attr.op = GT;
                  }
             | add_exp GE add_exp
-                 { $$ = newExpNode(OpK);
+                 { $$ = newExpNode(cc,OpK);
                    $$->child[0] = $1;
                    $$->child[1] = $3;
                    $$->attr.op = GE;
                  }
             | add_exp EQ add_exp
-                 { $$ = newExpNode(OpK);
+                 { $$ = newExpNode(cc,OpK);
                    $$->child[0] = $1;
                    $$->child[1] = $3;
                    $$->attr.op = EQ;
                  }
             | add_exp NE add_exp
-                 { $$ = newExpNode(OpK);
+                 { $$ = newExpNode(cc,OpK);
                    $$->child[0] = $1;
                    $$->child[1] = $3;
                    $$->attr.op = NE;
@@ -249,13 +260,13 @@ simple_exp  : add_exp LE add_exp
             | add_exp { $$ = $1; }
             ;
 add_exp     : add_exp PLUS term
-                 { $$ = newExpNode(OpK);
+                 { $$ = newExpNode(cc,OpK);
                    $$->child[0] = $1;
                    $$->child[1] = $3;
                    $$->attr.op = PLUS;
                  }
             | add_exp MINUS term
-                 { $$ = newExpNode(OpK);
+                 { $$ = newExpNode(cc,OpK);
                    $$->child[0] = $1;
                    $$->child[1] = $3;
                    $$->attr.op = MINUS;
@@ -263,13 +274,13 @@ add_exp     : add_exp PLUS term
             | term { $$ = $1; }
             ;
 term        : term TIMES factor 
-                 { $$ = newExpNode(OpK);
+                 { $$ = newExpNode(cc,OpK);
                    $$->child[0] = $1;
                    $$->child[1] = $3;
                    $$->attr.op = TIMES;
                  }
             | term OVER factor
-                 { $$ = newExpNode(OpK);
+                 { $$ = newExpNode(cc,OpK);
                    $$->child[0] = $1;
                    $$->child[1] = $3;
                    $$->attr.op = OVER;
@@ -280,52 +291,50 @@ factor      : LPAREN exp RPAREN { $$ = $2; }
             | var { $$ = $1; }
             | call { $$ = $1; }
             | saveNumber
-                 { $$ = newExpNode(ConstK);
-                   $$->attr.val = savedNumber;
+                 { $$ = newExpNode(cc,ConstK);
+                   $$->attr.val = cc->savedNumber;
                  }
             ;
 call        : saveName
-                 { $$ = newExpNode(CallK);
-                   $$->attr.name = savedName;
+                 { $<node>$ = newExpNode(cc,CallK);
+                   $<node>$->attr.name = cc->savedName;
                  }
               LPAREN args RPAREN
-                 { $$ = $2;
+                 { $$ = $<node>2;
                    $$->child[0] = $4;
                  }
             ;
-args        : arg_list  { $$ = $1; }
+args        : arg_list  { $$ = $1.head; }
             | { $$ = NULL; }
             ;
 arg_list    : arg_list COMMA exp
-                 { YYSTYPE t = $1;
-                   if(t != NULL)
-                   { while (t->sibling != NULL)
-                        t = t->sibling;
-                     t->sibling = $3;
-                     $$ = $1; }
-                     else $$ = $3;
-                 }
-            | exp { $$ = $1; }
+                 { $$ = $1;
+                   $$.tail->sibling = $3;
+                   $$.tail = $3;
+                 }
+            | exp { $$.head = $$.tail = $1; }
             ;
 
 %%
 
-int yyerror(char * message)
-{ fprintf(listing,"Syntax error at line %d: %s\n",lineno,message);
-  fprintf(listing,"Current token: ");
-  printToken(yychar,tokenString);
-  Error = TRUE;
+int yyerror(Compiler cc, char * message)
+{ fprintf(cc->listing,"Syntax error at line %d: %s\n",cc->lineno,message);
+  fprintf(cc->listing,"Current token: ");
+  printToken(cc,cc->lastToken,lexemeString(cc));
+  cc->Error = TRUE;
   return 0;
 }
 
 /* yylex calls getToken to make Yacc/Bison output
  * compatible with ealier versions of the TINY scanner
  */
-static int yylex(void)
-{ return getToken(); }
+static int yylex(YYSTYPE * lvalp, Compiler cc)
+{ (void) lvalp; /* tokens carry no value */
+  return cc->lastToken = getToken(cc);
+}
 
-TreeNode * parse(void)
-{ yyparse();
-  return savedTree;
+TreeNode * parse(Compiler cc)
+{ yyparse(cc);
+  return cc->savedTree;
 }
 
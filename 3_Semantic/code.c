@@ -6,22 +6,132 @@
 /* Kenneth C. Louden                                */
 /****************************************************/
 
+#include <stdarg.h>
 #include "globals.h"
 #include "code.h"
+#include "peep.h"
 
-/* TM location number for current instruction emission */
-static int emitLoc = 0 ;
+/* opcode names, indexed by object file opcode number */
+static char * opCodeTab[] = TMO_OPCODES;
 
-/* Highest TM location emitted so far
-   For use in conjunction with emitSkip,
-   emitBackup, and emitRestore */
-static int highEmitLoc = 0;
+/* the code being emitted for a compilation */
+typedef struct EmitRec
+{ /* TM location number for current instruction emission */
+  int emitLoc;
 
-/* Procedure emitComment prints a comment line 
+  /* Highest TM location emitted so far
+     For use in conjunction with emitSkip,
+     emitBackup, and emitRestore */
+  int highEmitLoc;
+
+  /* the code buffer: one entry per TM location,
+     backpatching writes straight into it */
+  TMCode * codeBuf;
+  int codeMax;
+
+  /* comment lines of the code file, each attached
+     to the location of the instruction after it */
+  TMOLine * lineTab;
+  int lineCount, lineMax;
+
+  /* text of all comments */
+  char * strPool;
+  int strSize, strMax;
+
+  /* output buffer for emitFinish */
+  char * outBuf;
+  int outSize, outMax;
+} * Emit;
+
+static void outOfMemory( Compiler cc )
+{ fprintf(cc->listing,"Out of memory error in code emission\n");
+  exit(1);
+}
+
+/* emitOf returns the code of cc, creating it
+   on first use */
+static Emit emitOf( Compiler cc )
+{ if (cc->emit == NULL)
+  { cc->emit = (Emit) calloc(1,sizeof(struct EmitRec));
+    if (cc->emit == NULL) outOfMemory(cc);
+  }
+  return cc->emit;
+}
+
+/* opNumber returns the object file opcode of op */
+static int opNumber( Compiler cc, char * op )
+{ int i;
+  for (i=0;i<TMO_NOPCODES;i++)
+    if (strcmp(opCodeTab[i],op) == 0) return i;
+  fprintf(cc->listing,"BUG: unknown TM opcode %s\n",op);
+  return 0;
+}
+
+/* addString copies c into the comment text
+   and returns its offset */
+static int addString( Compiler cc, char * c )
+{ Emit e = emitOf(cc);
+  int n = strlen(c)+1;
+  int at = e->strSize;
+  while (e->strSize+n > e->strMax)
+  { e->strMax = e->strMax ? 2*e->strMax : 4096;
+    e->strPool = realloc(e->strPool,e->strMax);
+    if (e->strPool == NULL) outOfMemory(cc);
+  }
+  memcpy(e->strPool+e->strSize,c,n);
+  e->strSize += n;
+  return at;
+}
+
+/* codeAt returns the buffer entry of location loc */
+static TMCode * codeAt( Compiler cc, int loc )
+{ Emit e = emitOf(cc);
+  int i;
+  if (loc >= e->codeMax)
+  { i = e->codeMax;
+    e->codeMax = e->codeMax ? 2*e->codeMax : 1024;
+    while (e->codeMax <= loc) e->codeMax *= 2;
+    e->codeBuf = realloc(e->codeBuf,e->codeMax*sizeof(TMCode));
+    if (e->codeBuf == NULL) outOfMemory(cc);
+    for ( ; i < e->codeMax; i++)
+    { memset(&e->codeBuf[i].inst,0,sizeof(TMOInst));
+      e->codeBuf[i].comment = -1;
+      e->codeBuf[i].used = FALSE;
+    }
+  }
+  return &e->codeBuf[loc];
+}
+
+/* emitInst stores an instruction at emitLoc */
+static void emitInst( Compiler cc, char * op, int r, int s, int t, char * c )
+{ Emit e = emitOf(cc);
+  TMCode * p = codeAt(cc,e->emitLoc);
+  p->inst.iop = opNumber(cc,op);
+  p->inst.iarg1 = r;
+  p->inst.iarg2 = s;
+  p->inst.iarg3 = t;
+  p->comment = TraceCode ? addString(cc,c) : -1;
+  p->used = TRUE;
+  e->emitLoc++;
+  if (e->highEmitLoc < e->emitLoc) e->highEmitLoc = e->emitLoc ;
+}
+
+/* Procedure emitComment prints a comment line
  * with comment c in the code file
  */
-void emitComment( char * c )
-{ if (TraceCode) fprintf(code,"* %s\n",c);}
+void emitComment( Compiler cc, char * c )
+{ Emit e = emitOf(cc);
+  if (TraceCode)
+  { if (e->lineCount == e->lineMax)
+    { e->lineMax = e->lineMax ? 2*e->lineMax : 256;
+      e->lineTab = realloc(e->lineTab,e->lineMax*sizeof(TMOLine));
+      if (e->lineTab == NULL) outOfMemory(cc);
+    }
+    e->lineTab[e->lineCount].loc = e->emitLoc;
+    e->lineTab[e->lineCount].str = addString(cc,c);
+    e->lineCount++;
+  }
+}
 
 /* Procedure emitRO emits a register-only
  * TM instruction
@@ -31,11 +141,8 @@ void emitComment( char * c )
  * t = 2nd source register
  * c = a comment to be printed if TraceCode is TRUE
  */
-void emitRO( char *op, int r, int s, int t, char *c)
-{ fprintf(code,"%3d:  %5s  %d,%d,%d ",emitLoc++,op,r,s,t);
-  if (TraceCode) fprintf(code,"\t%s",c) ;
-  fprintf(code,"\n") ;
-  if (highEmitLoc < emitLoc) highEmitLoc = emitLoc ;
+void emitRO( Compiler cc, char *op, int r, int s, int t, char *c)
+{ emitInst(cc,op,r,s,t,c);
 } /* emitRO */
 
 /* Procedure emitRM emits a register-to-memory
@@ -46,40 +153,41 @@ void emitRO( char *op, int r, int s, int t, char *c)
  * s = the base register
  * c = a comment to be printed if TraceCode is TRUE
  */
-void emitRM( char * op, int r, int d, int s, char *c)
-{ fprintf(code,"%3d:  %5s  %d,%d(%d) ",emitLoc++,op,r,d,s);
-  if (TraceCode) fprintf(code,"\t%s",c) ;
-  fprintf(code,"\n") ;
-  if (highEmitLoc < emitLoc)  highEmitLoc = emitLoc ;
+void emitRM( Compiler cc, char * op, int r, int d, int s, char *c)
+{ emitInst(cc,op,r,d,s,c);
 } /* emitRM */
 
 /* Function emitSkip skips "howMany" code
  * locations for later backpatch. It also
  * returns the current code position
  */
-int emitSkip( int howMany)
-{  int i = emitLoc;
-   emitLoc += howMany ;
-   if (highEmitLoc < emitLoc)  highEmitLoc = emitLoc ;
+int emitSkip( Compiler cc, int howMany)
+{  Emit e = emitOf(cc);
+   int i = e->emitLoc;
+   e->emitLoc += howMany ;
+   if (e->highEmitLoc < e->emitLoc)  e->highEmitLoc = e->emitLoc ;
    return i;
 } /* emitSkip */
 
-/* Procedure emitBackup backs up to 
+/* Procedure emitBackup backs up to
  * loc = a previously skipped location
  */
-void emitBackup( int loc)
-{ if (loc > highEmitLoc) emitComment("BUG in emitBackup");
-  emitLoc = loc ;
+void emitBackup( Compiler cc, int loc)
+{ Emit e = emitOf(cc);
+  if (loc > e->highEmitLoc) emitComment(cc,"BUG in emitBackup");
+  e->emitLoc = loc ;
 } /* emitBackup */
 
-/* Procedure emitRestore restores the current 
+/* Procedure emitRestore restores the current
  * code position to the highest previously
  * unemitted position
  */
-void emitRestore(void)
-{ emitLoc = highEmitLoc;}
+void emitRestore( Compiler cc )
+{ Emit e = emitOf(cc);
+  e->emitLoc = e->highEmitLoc;
+}
 
-/* Procedure emitRM_Abs converts an absolute reference 
+/* Procedure emitRM_Abs converts an absolute reference
  * to a pc-relative reference when emitting a
  * register-to-memory TM instruction
  * op = the opcode
@@ -87,11 +195,150 @@ void emitRestore(void)
  * a = the absolute location in memory
  * c = a comment to be printed if TraceCode is TRUE
  */
-void emitRM_Abs( char *op, int r, int a, char * c)
-{ fprintf(code,"%3d:  %5s  %d,%d(%d) ",
-               emitLoc,op,r,a-(emitLoc+1),pc);
-  ++emitLoc ;
-  if (TraceCode) fprintf(code,"\t%s",c) ;
-  fprintf(code,"\n") ;
-  if (highEmitLoc < emitLoc) highEmitLoc = emitLoc ;
+void emitRM_Abs( Compiler cc, char *op, int r, int a, char * c)
+{ Emit e = emitOf(cc);
+  emitInst(cc,op,r,a-(e->emitLoc+1),pc,c);
 } /* emitRM_Abs */
+
+/* outReserve makes room for n more bytes of output */
+static void outReserve( Compiler cc, int n )
+{ Emit e = emitOf(cc);
+  while (e->outSize+n > e->outMax)
+  { e->outMax = e->outMax ? 2*e->outMax : 65536;
+    e->outBuf = realloc(e->outBuf,e->outMax);
+    if (e->outBuf == NULL) outOfMemory(cc);
+  }
+}
+
+/* outPrintf appends formatted text to the output */
+static void outPrintf( Compiler cc, const char * fmt, ... )
+{ Emit e = emitOf(cc);
+  va_list ap;
+  int n;
+  outReserve(cc,256);
+  va_start(ap,fmt);
+  n = vsnprintf(e->outBuf+e->outSize,e->outMax-e->outSize,fmt,ap);
+  va_end(ap);
+  if (n >= e->outMax-e->outSize)
+  { outReserve(cc,n+1);
+    va_start(ap,fmt);
+    vsnprintf(e->outBuf+e->outSize,e->outMax-e->outSize,fmt,ap);
+    va_end(ap);
+  }
+  e->outSize += n;
+}
+
+/* outWrite appends n bytes to the output */
+static void outWrite( Compiler cc, const void * p, int n )
+{ Emit e = emitOf(cc);
+  outReserve(cc,n);
+  memcpy(e->outBuf+e->outSize,p,n);
+  e->outSize += n;
+}
+
+/* lineCompare orders comment lines by location,
+   keeping emission order within one location */
+static int lineCompare( const void * a, const void * b )
+{ const TMOLine * x = a, * y = b;
+  if (x->loc != y->loc) return x->loc - y->loc;
+  return x->str - y->str;
+}
+
+/* writeText formats the buffer as TM assembly */
+static void writeText( Compiler cc )
+{ Emit e = emitOf(cc);
+  int loc, l = 0;
+  TMCode * p;
+  for (loc = 0; loc <= e->highEmitLoc; loc++)
+  { for ( ; (l < e->lineCount) && (e->lineTab[l].loc <= loc); l++)
+      outPrintf(cc,"* %s\n",e->strPool+e->lineTab[l].str);
+    if (loc == e->highEmitLoc) break;
+    p = &e->codeBuf[loc];
+    if (!p->used) continue;
+    if (p->inst.iop < tmoRRLim)
+      outPrintf(cc,"%3d:  %5s  %d,%d,%d ",loc,opCodeTab[p->inst.iop],
+                p->inst.iarg1,p->inst.iarg2,p->inst.iarg3);
+    else
+      outPrintf(cc,"%3d:  %5s  %d,%d(%d) ",loc,opCodeTab[p->inst.iop],
+                p->inst.iarg1,p->inst.iarg2,p->inst.iarg3);
+    if (p->comment >= 0) outPrintf(cc,"\t%s",e->strPool+p->comment);
+    outPrintf(cc,"\n");
+  }
+}
+
+/* writeObject formats the buffer as a binary
+   object file (see tmo.h) */
+static void writeObject( Compiler cc )
+{ Emit e = emitOf(cc);
+  TMOHeader h;
+  TMOLine line;
+  int loc, l, n = 0;
+  for (loc = 0; loc < e->highEmitLoc; loc++)
+    if (e->codeBuf[loc].comment >= 0) n++;
+  memcpy(h.magic,TMO_MAGIC,4);
+  h.version = TMO_VERSION;
+  h.byteOrder = 1;
+  h.instSize = sizeof(TMOInst);
+  h.instCount = e->highEmitLoc;
+  h.dataCount = 0; /* no initialized data yet */
+  h.lineCount = e->lineCount + n;
+  h.strSize = e->strSize;
+  outWrite(cc,&h,sizeof(h));
+  for (loc = 0; loc < e->highEmitLoc; loc++)
+    outWrite(cc,&e->codeBuf[loc].inst,sizeof(TMOInst));
+  /* comment lines of a location come before
+     the comment of its instruction */
+  l = 0;
+  for (loc = 0; loc <= e->highEmitLoc; loc++)
+  { for ( ; (l < e->lineCount) && (e->lineTab[l].loc <= loc); l++)
+    { line.loc = loc < e->highEmitLoc ? loc : e->highEmitLoc - 1;
+      line.str = e->lineTab[l].str;
+      outWrite(cc,&line,sizeof(line));
+    }
+    if ((loc < e->highEmitLoc) && (e->codeBuf[loc].comment >= 0))
+    { line.loc = loc;
+      line.str = e->codeBuf[loc].comment;
+      outWrite(cc,&line,sizeof(line));
+    }
+  }
+  outWrite(cc,e->strPool,e->strSize);
+}
+
+/* Procedure emitFinish writes the code buffer
+ * to the code file in address order; it is
+ * called after the last instruction is emitted
+ */
+void emitFinish( Compiler cc )
+{ Emit e = emitOf(cc);
+  int * newLoc;
+  int i, n;
+  if (e->highEmitLoc > 0) codeAt(cc,e->highEmitLoc-1);
+  if (OptimizeCode)
+  { newLoc = malloc((e->highEmitLoc+1)*sizeof(int));
+    if (newLoc == NULL) outOfMemory(cc);
+    n = peephole(cc,e->codeBuf,e->highEmitLoc,newLoc);
+    for (i = 0; i < e->lineCount; i++)
+      e->lineTab[i].loc = newLoc[e->lineTab[i].loc];
+    fprintf(cc->listing,"Peephole optimizer: %d of %d TM instructions removed\n",
+            e->highEmitLoc-n,e->highEmitLoc);
+    free(newLoc);
+    e->highEmitLoc = e->emitLoc = n;
+  }
+  qsort(e->lineTab,e->lineCount,sizeof(TMOLine),lineCompare);
+  e->outSize = 0;
+  if (BinaryCode) writeObject(cc);
+  else writeText(cc);
+  fwrite(e->outBuf,1,e->outSize,cc->code);
+} /* emitFinish */
+
+/* Procedure emitFree releases the code of cc */
+void emitFree( Compiler cc )
+{ Emit e = cc->emit;
+  if (e == NULL) return;
+  free(e->codeBuf);
+  free(e->lineTab);
+  free(e->strPool);
+  free(e->outBuf);
+  free(e);
+  cc->emit = NULL;
+}
@@ -9,6 +9,8 @@
 #ifndef _CODE_H_
 #define _CODE_H_
 
+#include "tmo.h"
+
 /* pc = program counter  */
 #define  pc 7
 
@@ -23,18 +25,36 @@
  */
 #define gp 5
 
+/* fp = "frame pointer" points to the
+ * activation record of the running function
+ */
+#define fp 4
+
 /* accumulator */
 #define  ac 0
 
 /* 2nd accumulator */
 #define  ac1 1
 
-/* code emitting utilities */
+/* TMCode is one location of the in-memory code
+ * buffer that the emitting utilities fill in
+ */
+typedef struct
+{
+  TMOInst inst; /* opcode number and operands, RM  */
+                /* instructions store r,d,s        */
+  int comment;  /* offset of the comment text, -1 if none */
+  int used;     /* FALSE for a location never emitted */
+} TMCode;
+
+/* code emitting utilities; each emits into
+ * the code buffer of compilation cc
+ */
 
 /* Procedure emitComment prints a comment line 
  * with comment c in the code file
  */
-void emitComment( char * c );
+void emitComment( Compiler cc, char * c );
 
 /* Procedure emitRO emits a register-only
  * TM instruction
@@ -44,7 +64,7 @@ void emitComment( char * c );
  * t = 2nd source register
  * c = a comment to be printed if TraceCode is TRUE
  */
-void emitRO( char *op, int r, int s, int t, char *c);
+void emitRO( Compiler cc, char *op, int r, int s, int t, char *c);
 
 /* Procedure emitRM emits a register-to-memory
  * TM instruction
@@ -54,24 +74,24 @@ void emitRO( char *op, int r, int s, int t, char *c);
  * s = the base register
  * c = a comment to be printed if TraceCode is TRUE
  */
-void emitRM( char * op, int r, int d, int s, char *c);
+void emitRM( Compiler cc, char * op, int r, int d, int s, char *c);
 
 /* Function emitSkip skips "howMany" code
  * locations for later backpatch. It also
  * returns the current code position
  */
-int emitSkip( int howMany);
+int emitSkip( Compiler cc, int howMany);
 
 /* Procedure emitBackup backs up to 
  * loc = a previously skipped location
  */
-void emitBackup( int loc);
+void emitBackup( Compiler cc, int loc);
 
 /* Procedure emitRestore restores the current 
  * code position to the highest previously
  * unemitted position
  */
-void emitRestore(void);
+void emitRestore( Compiler cc );
 
 /* Procedure emitRM_Abs converts an absolute reference 
  * to a pc-relative reference when emitting a
@@ -81,6 +101,20 @@ void emitRestore(void);
  * a = the absolute location in memory
  * c = a comment to be printed if TraceCode is TRUE
  */
-void emitRM_Abs( char *op, int r, int a, char * c);
+void emitRM_Abs( Compiler cc, char *op, int r, int a, char * c);
+
+/* Procedure emitFinish writes the code buffer
+ * to the code file in address order, as TM text
+ * or as a binary object file when BinaryCode is
+ * TRUE, after the peephole optimizer when
+ * OptimizeCode is TRUE; it is called after the
+ * last instruction is emitted
+ */
+void emitFinish( Compiler cc );
+
+/* Procedure emitFree releases the code buffer
+ * of cc
+ */
+void emitFree( Compiler cc );
 
 #endif
@@ -0,0 +1,37 @@
+/****************************************************/
+/* File: compiler.c                                 */
+/* Compiler contexts for the C-MINUS compiler       */
+/****************************************************/
+
+#include "globals.h"
+#include "compiler.h"
+#include "scan.h"
+#include "arena.h"
+#include "intern.h"
+#include "symtab.h"
+#include "analyze.h"
+#include "code.h"
+#include "cgen.h"
+
+Compiler newCompiler( FILE * source, FILE * listing )
+{ Compiler cc = (Compiler) calloc(1,sizeof(struct CompilerRec));
+  if (cc == NULL)
+  { fprintf(listing,"Out of memory error in newCompiler\n");
+    exit(1);
+  }
+  cc->source = source;
+  cc->listing = listing;
+  return cc;
+}
+
+void freeCompiler( Compiler cc )
+{ scanFree(cc);
+  analyzeFree(cc);
+  st_free(cc);
+  cgenFree(cc);
+  emitFree(cc);
+  internFree(cc);
+  /* the syntax tree and its strings go at once */
+  arenaFree(cc);
+  free(cc);
+}
@@ -0,0 +1,22 @@
+/****************************************************/
+/* File: compiler.h                                 */
+/* Compiler contexts for the C-MINUS compiler       */
+/****************************************************/
+
+#ifndef _COMPILER_H_
+#define _COMPILER_H_
+
+/* Function newCompiler returns a new context for
+ * the compilation of source with the listing
+ * written to listing; it exits on failure
+ */
+Compiler newCompiler( FILE * source, FILE * listing );
+
+/* Procedure freeCompiler releases a context and
+ * everything allocated by the compilation,
+ * the syntax tree and symbol table included;
+ * it does not close the files
+ */
+void freeCompiler( Compiler cc );
+
+#endif
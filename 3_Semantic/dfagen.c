@@ -0,0 +1,162 @@
+/****************************************************/
+/* File: dfagen.c                                   */
+/* Generates the tables of the table-driven core    */
+/* of the C-MINUS scanner: writes scandfa.h to      */
+/* standard output                                  */
+/****************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* MAXSTATES = the largest number of DFA states */
+#define MAXSTATES 128
+
+/* the tokens of the states; state 0 is the
+   DFA_DONE marker, state 1 the start state */
+static const char * token[MAXSTATES];
+/* the kinds of run of chars that the states
+   loop on, as skipped in bulk by spanRun */
+static const char * run[MAXSTATES];
+static int next[MAXSTATES][256];
+static int nStates = 1;
+
+static int newState( const char * tok )
+{ if (nStates == MAXSTATES)
+  { fprintf(stderr,"dfagen: too many states\n");
+    exit(1);
+  }
+  token[nStates] = tok;
+  run[nStates] = "DFA_NORUN";
+  return nStates++;
+}
+
+static int isLetter( int c )
+{ return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')); }
+
+static int isDigit( int c )
+{ return (c >= '0') && (c <= '9'); }
+
+/* COUNT is the number of elements of array a */
+#define COUNT(a) ((int) (sizeof(a) / sizeof((a)[0])))
+
+/* the reserved words and their tokens */
+static struct { const char * str; const char * tok; } reserved[] =
+  { {"if","IF"}, {"else","ELSE"}, {"while","WHILE"},
+    {"return","RETURN"}, {"int","INT"}, {"void","VOID"} };
+
+/* the tokens of one char that starts no other token */
+static struct { int c; const char * tok; } single[] =
+  { {'+',"PLUS"}, {'-',"MINUS"}, {'*',"TIMES"},
+    {'(',"LPAREN"}, {')',"RPAREN"}, {'[',"LBRACE"},
+    {']',"RBRACE"}, {'{',"LCURLY"}, {'}',"RCURLY"},
+    {';',"SEMI"}, {',',"COMMA"} };
+
+/* twoChar adds the token of c, which becomes tok2
+   when followed by '=' */
+static void twoChar( int start, int c, const char * tok, const char * tok2 )
+{ int s = newState(tok);
+  next[start][c] = s;
+  next[s]['='] = newState(tok2);
+}
+
+int main( void )
+{ int start, blank, id, num, err, s, t, c, i, j, k;
+  int slash, comment, star, end;
+  int class[256], nClasses = 0, rep[256];
+
+  start = newState("ENDFILE"); /* at the end of the source */
+  blank = newState("DFA_SKIP");
+  id = newState("ID");
+  num = newState("NUM");
+  err = newState("ERROR");
+  run[blank] = "RunBlanks";
+  run[id] = "RunLetters";
+  run[num] = "RunDigits";
+
+  for (c = 0; c < 256; c++) next[start][c] = err;
+  next[start][' '] = next[start]['\t'] = next[start]['\n'] = blank;
+  next[blank][' '] = next[blank]['\t'] = next[blank]['\n'] = blank;
+  for (c = 0; c < 256; c++)
+  { if (isLetter(c)) next[start][c] = next[id][c] = id;
+    if (isDigit(c)) next[start][c] = next[num][c] = num;
+  }
+
+  /* the reserved words form a trie of ID states */
+  for (i = 0; i < COUNT(reserved); i++)
+  { s = start;
+    for (j = 0; reserved[i].str[j] != '\0'; j++)
+    { c = reserved[i].str[j];
+      t = next[s][c];
+      if (t == id)
+      { t = newState("ID");
+        for (k = 0; k < 256; k++)
+          if (isLetter(k)) next[t][k] = id;
+        next[s][c] = t;
+      }
+      s = t;
+    }
+    token[s] = reserved[i].tok;
+  }
+
+  for (i = 0; i < COUNT(single); i++)
+    next[start][single[i].c] = newState(single[i].tok);
+  twoChar(start,'=',"ASSIGN","EQ");
+  twoChar(start,'<',"LT","LE");
+  twoChar(start,'>',"GT","GE");
+  twoChar(start,'!',"ERROR","NE");
+
+  /* a comment is skipped like blanks; the source
+     ends in ENDFILE inside an unclosed comment */
+  slash = newState("OVER");
+  comment = newState("ENDFILE");
+  star = newState("ENDFILE");
+  end = newState("DFA_SKIP");
+  run[comment] = "RunComment";
+  next[start]['/'] = slash;
+  next[slash]['*'] = comment;
+  for (c = 0; c < 256; c++)
+  { next[comment][c] = comment;
+    next[star][c] = comment;
+  }
+  next[comment]['*'] = star;
+  next[star]['*'] = star;
+  next[star]['/'] = end;
+
+  /* chars with equal columns share a class */
+  for (c = 0; c < 256; c++)
+  { for (k = 0; k < nClasses; k++)
+    { for (s = 1; s < nStates; s++)
+        if (next[s][c] != next[s][rep[k]]) break;
+      if (s == nStates) break;
+    }
+    if (k == nClasses) rep[nClasses++] = c;
+    class[c] = k;
+  }
+
+  printf("/* scandfa.h: generated by dfagen for scan.c, do not edit */\n\n");
+  printf("#define DFA_NSTATES %d\n",nStates);
+  printf("#define DFA_NCLASSES %d\n",nClasses);
+  printf("#define DFA_DONE 0\n");
+  printf("#define DFA_START %d\n\n",start);
+  printf("static const unsigned char dfaClass[256] =\n  {");
+  for (c = 0; c < 256; c++)
+    printf("%s%2d%s",(c % 16) ? "" : "\n    ",class[c],(c < 255) ? "," : "");
+  printf("\n  };\n\n");
+  printf("static const unsigned char dfaNext[DFA_NSTATES][DFA_NCLASSES] =\n  {");
+  for (s = 0; s < nStates; s++)
+  { printf("\n    {");
+    for (k = 0; k < nClasses; k++)
+      printf("%s%d",k ? "," : "",next[s][rep[k]]);
+    printf("}%s",(s < nStates - 1) ? "," : "");
+  }
+  printf("\n  };\n\n");
+  printf("static const int dfaToken[DFA_NSTATES] =\n  { 0");
+  for (s = 1; s < nStates; s++)
+    printf(",%s%s",(s % 6) ? " " : "\n    ",token[s]);
+  printf("\n  };\n\n");
+  printf("static const int dfaRun[DFA_NSTATES] =\n  { DFA_NORUN");
+  for (s = 1; s < nStates; s++)
+    printf(",%s%s",(s % 4) ? " " : "\n    ",run[s]);
+  printf("\n  };\n");
+  return 0;
+}
@@ -0,0 +1,214 @@
+/****************************************************/
+/* File: driver.c                                   */
+/* Compilation driver for the C-MINUS compiler:     */
+/* compiles one program, or many on a pool of       */
+/* worker threads                                   */
+/****************************************************/
+
+#include <pthread.h>
+#include "globals.h"
+
+/* set NO_PARSE to TRUE to get a scanner-only compiler */
+#define NO_PARSE FALSE
+/* set NO_ANALYZE to TRUE to get a parser-only compiler */
+#define NO_ANALYZE FALSE
+
+/* set NO_CODE to TRUE to get a compiler that does not
+ * generate code
+ */
+#define NO_CODE FALSE
+
+#include "util.h"
+#include "arena.h"
+#include "compiler.h"
+#include "driver.h"
+#if NO_PARSE
+#include "scan.h"
+#else
+#include "parse.h"
+#if !NO_ANALYZE
+#include "analyze.h"
+#include "symtab.h"
+#if !NO_CODE
+#include "cgen.h"
+#endif
+#endif
+#endif
+
+int compileFile(const char *pgm, FILE *listing)
+{
+  TreeNode *syntaxTree;
+  Compiler cc;
+  FILE *source;
+  int ok;
+  source = fopen(pgm, "r");
+  if (source == NULL)
+  {
+    fprintf(stderr, "File %s not found\n", pgm);
+    return FALSE;
+  }
+  fprintf(listing, "\nC-MINUS COMPILATION: %s\n", pgm);
+  cc = newCompiler(source, listing);
+#if NO_PARSE
+  while (getToken(cc) != ENDFILE)
+    ;
+#else
+  syntaxTree = parseParallel(cc, ParseThreads);
+  if (TraceParse)
+  {
+    fprintf(listing, "\nSyntax tree:\n");
+    printTree(cc, syntaxTree);
+  }
+#if !NO_ANALYZE
+  if (!cc->Error)
+  {
+    // fprintf(listing, "\n");
+    if (FuseAnalysis)
+      analyze(cc, syntaxTree);
+    else
+    {
+      buildSymtab(cc, syntaxTree);
+      typeCheck(cc, syntaxTree);
+    }
+    if (TraceAnalyze && !cc->Error)
+    {
+      fprintf(listing, "\nBuilding Symbol Table...\n");
+      printSymTab(cc, listing);
+      fprintf(listing, "\nChecking Types...\n");
+      fprintf(listing, "\nType Checking Finished\n\n");
+    }
+  }
+#if !NO_CODE
+  if (!cc->Error)
+  {
+    char *codefile;
+    int fnlen = strcspn(pgm, ".");
+    codefile = (char *)calloc(fnlen + 5, sizeof(char));
+    strncpy(codefile, pgm, fnlen);
+    strcat(codefile, BinaryCode ? ".tmo" : ".tm");
+    cc->code = fopen(codefile, BinaryCode ? "wb" : "w");
+    if (cc->code == NULL)
+    {
+      fprintf(listing, "Unable to open %s\n", codefile);
+      cc->Error = TRUE;
+    }
+    else
+    {
+      codeGen(cc, syntaxTree, codefile);
+      fclose(cc->code);
+    }
+    free(codefile);
+  }
+#endif
+#endif
+#endif
+  fclose(source);
+  if (TraceMemory)
+    arenaStats(cc);
+  ok = !cc->Error;
+  /* everything the compilation allocated goes at once */
+  freeCompiler(cc);
+  return ok;
+}
+
+/* a program given to compileFiles; its listing is
+ * kept in memory until the listings before it are
+ * written
+ */
+typedef struct
+{
+  const char *pgm;
+  char *text; /* the listing */
+  size_t size;
+  int ok;
+  int done; /* TRUE once text is complete */
+} Job;
+
+/* the jobs shared by the worker threads */
+typedef struct
+{
+  Job *jobs;
+  int n;
+  int next; /* the next job to start */
+  pthread_mutex_t lock;
+  pthread_cond_t finished; /* signals a job done */
+} Pool;
+
+/* worker compiles jobs of pool until none is left */
+static void *worker(void *arg)
+{
+  Pool *pool = (Pool *)arg;
+  Job *job;
+  FILE *listing;
+  int ok;
+  for (;;)
+  {
+    pthread_mutex_lock(&pool->lock);
+    job = (pool->next < pool->n) ? &pool->jobs[pool->next++] : NULL;
+    pthread_mutex_unlock(&pool->lock);
+    if (job == NULL)
+      return NULL;
+    listing = open_memstream(&job->text, &job->size);
+    if (listing == NULL)
+    {
+      fprintf(stderr, "Out of memory error in compileFiles\n");
+      exit(1);
+    }
+    ok = compileFile(job->pgm, listing);
+    fclose(listing);
+    pthread_mutex_lock(&pool->lock);
+    job->ok = ok;
+    job->done = TRUE;
+    pthread_cond_broadcast(&pool->finished);
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
+
+int compileFiles(char **pgms, int n, int nThreads, FILE *listing)
+{
+  Pool pool;
+  pthread_t *threads;
+  int i, failed = 0;
+  if (nThreads > n)
+    nThreads = n;
+  if (nThreads < 1)
+    nThreads = 1;
+  pool.jobs = (Job *)calloc(n + 1, sizeof(Job));
+  threads = (pthread_t *)malloc(nThreads * sizeof(pthread_t));
+  if ((pool.jobs == NULL) || (threads == NULL))
+  {
+    fprintf(stderr, "Out of memory error in compileFiles\n");
+    exit(1);
+  }
+  for (i = 0; i < n; i++)
+    pool.jobs[i].pgm = pgms[i];
+  pool.n = n;
+  pool.next = 0;
+  pthread_mutex_init(&pool.lock, NULL);
+  pthread_cond_init(&pool.finished, NULL);
+  for (i = 0; i < nThreads; i++)
+    if (pthread_create(&threads[i], NULL, worker, &pool) != 0)
+    {
+      fprintf(stderr, "Unable to start a compiler thread\n");
+      exit(1);
+    }
+  /* write the listings in order as they complete */
+  for (i = 0; i < n; i++)
+  {
+    pthread_mutex_lock(&pool.lock);
+    while (!pool.jobs[i].done)
+      pthread_cond_wait(&pool.finished, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+    fwrite(pool.jobs[i].text, 1, pool.jobs[i].size, listing);
+    free(pool.jobs[i].text);
+    if (!pool.jobs[i].ok)
+      failed++;
+  }
+  for (i = 0; i < nThreads; i++)
+    pthread_join(threads[i], NULL);
+  pthread_cond_destroy(&pool.finished);
+  pthread_mutex_destroy(&pool.lock);
+  free(threads);
+  free(pool.jobs);
+  return failed;
+}
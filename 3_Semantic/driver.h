@@ -0,0 +1,25 @@
+/****************************************************/
+/* File: driver.h                                   */
+/* Compilation driver for the C-MINUS compiler      */
+/****************************************************/
+
+#ifndef _DRIVER_H_
+#define _DRIVER_H_
+
+/* Function compileFile compiles the program pgm,
+ * writing its listing to listing and its code next
+ * to it; it returns TRUE if pgm compiled without
+ * errors
+ */
+int compileFile(const char *pgm, FILE *listing);
+
+/* Function compileFiles compiles the n programs
+ * pgms on nThreads worker threads, each with its
+ * own compiler context. The listings are written
+ * to listing one after another in the order of
+ * pgms. It returns the number of programs that
+ * failed to compile
+ */
+int compileFiles(char **pgms, int n, int nThreads, FILE *listing);
+
+#endif
@@ -24,6 +24,11 @@
  * into the Yacc/Bison output itself
  */
 
+/* the parser takes the compiler context of
+ * the next section, declared here for tab.h
+ */
+typedef struct CompilerRec * Compiler;
+
 #ifndef YYPARSER
 
 /* the name of the following file may change */
@@ -45,19 +50,16 @@
 #endif
 
 /* MAXRESERVED = the number of reserved words */
-#define MAXRESERVED 8
+#define MAXRESERVED 6
+
+/* MAXTOKENLEN is the maximum size of a token */
+#define MAXTOKENLEN 40
 
 /* Yacc/Bison generates its own integer values
  * for tokens
  */
 typedef int TokenType;
 
-extern FILE *source;  /* source code text file */
-extern FILE *listing; /* listing output text file */
-extern FILE *code;    /* code text file for TM simulator */
-
-extern int lineno; /* source line number for listing */
-
 /**************************************************/
 /***********   Syntax tree for parsing ************/
 /**************************************************/
@@ -121,7 +123,7 @@ typedef enum
 
 #define MAXCHILDREN 3
 
-struct ScopeRec;
+struct ScopeListRec;
 
 typedef struct treeNode
 {
@@ -144,11 +146,69 @@ typedef struct treeNode
     int val;
     char *name;
     ArrayAttr arr;
-    struct Scope *scope;
+    struct ScopeListRec *scope;
   } attr;
   ExpType type; /* for type checking of exps */
 } TreeNode;
 
+/**************************************************/
+/***********   Compiler context        ************/
+/**************************************************/
+
+/* A Compiler holds the state of one compilation,
+ * so that independent compilations can share a
+ * process; every phase takes it as its first
+ * argument. The state private to a phase is
+ * created by that phase on first use and released
+ * by freeCompiler (compiler.h)
+ */
+struct CompilerRec
+{
+  FILE *source;  /* source code text file */
+  FILE *listing; /* listing output text file */
+  FILE *code;    /* code text file for TM simulator */
+  int lineno;    /* source line number for listing */
+  int Error;     /* TRUE prevents further passes */
+
+  /* the lexeme of the current token: lexemeLength
+   * chars at lexeme, not terminated, in the text
+   * buffer of the scanner until the next token
+   */
+  const char *lexeme;
+  int lexemeLength;
+
+  /* the attribute of the current token when the
+   * scanner has it from a token batch: the interned
+   * name of an ID or the value of a NUM; tokenAttr
+   * is FALSE if it comes from the lexeme
+   */
+  int tokenAttr;
+  char *tokenName;
+  int tokenValue;
+
+  /* the lexeme as a string for the listing,
+   * made by lexemeString (util.h)
+   */
+  char tokenString[MAXTOKENLEN + 1];
+
+  /* values saved by the parser for later actions */
+  TokenType lastToken; /* token last read, for errors */
+  char *savedName;
+  int savedNumber;
+  int savedLineNo;
+  TreeNode *savedTree;
+
+  int indentno; /* current indentation of printTree */
+
+  void *scanner;                 /* scanner state */
+  struct ArenaRec *arena;        /* arena.c */
+  struct InternTableRec *names;  /* intern.c */
+  struct SymTabRec *symtab;      /* symtab.c */
+  struct AnalyzeRec *analyze;    /* analyze.c */
+  struct EmitRec *emit;          /* code.c */
+  struct CGenRec *cgen;          /* cgen.c */
+};
+
 /**************************************************/
 /***********   Flags for tracing       ************/
 /**************************************************/
@@ -181,6 +241,63 @@ extern int TraceAnalyze;
  */
 extern int TraceCode;
 
-/* Error = TRUE prevents further passes if an error occurs */
-extern int Error;
+/* BinaryCode = TRUE causes the code file to be
+ * written in the binary TM object format (tmo.h)
+ * instead of TM assembly text
+ */
+extern int BinaryCode;
+
+/* OptimizeCode = TRUE runs the peephole optimizer
+ * over the TM code before it is written
+ */
+extern int OptimizeCode;
+
+/* TraceMemory = TRUE causes the arena statistics
+ * to be printed to the listing file at the end
+ */
+extern int TraceMemory;
+
+/* FuseAnalysis = TRUE builds the symbol table and
+ * checks types in a single traversal of the tree;
+ * a program gets the same errors, but in source
+ * order, not declaration errors before type errors
+ */
+extern int FuseAnalysis;
+
+/* MapSource = TRUE lets the scanner map a source
+ * file into memory and scan it in place instead
+ * of reading it in blocks
+ */
+extern int MapSource;
+
+/* TableScan = TRUE scans with the table-driven DFA
+ * generated by dfagen instead of the hand-coded one;
+ * a source echoed is always scanned by the latter
+ */
+extern int TableScan;
+
+/* BatchTokens = TRUE lets the scanner queue the
+ * tokens for the parser in batches, scanning ahead
+ * in a tight loop; a source echoed is scanned a
+ * token at a time
+ */
+extern int BatchTokens;
+
+/* PipelineScan = TRUE scans a large mapped source
+ * on a thread of its own, which queues the tokens
+ * for the parser as it goes
+ */
+extern int PipelineScan;
+
+/* ParseThreads > 1 parses a large mapped source in
+ * as many pieces, split between its top-level
+ * declarations, on as many threads
+ */
+extern int ParseThreads;
+
+/* AnalyzeThreads > 1 analyzes the function bodies
+ * of a large program on as many threads, after its
+ * globals are declared
+ */
+extern int AnalyzeThreads;
 #endif
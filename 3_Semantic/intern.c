@@ -0,0 +1,77 @@
+/****************************************************/
+/* File: intern.c                                   */
+/* Identifier interning for the C-MINUS compiler    */
+/****************************************************/
+
+#include "globals.h"
+#include "intern.h"
+#include "arena.h"
+
+/* the table of a compilation has a power of two
+   buckets and grows when it holds as many strings */
+struct InternTableRec
+{ InternEntry * table;
+  int tableSize;
+  int count;
+};
+
+/* bucketOf spreads the hash over the buckets */
+static int bucketOf( int hash, int size )
+{ return (int) (((unsigned) hash * 2654435761u) & (unsigned) (size-1)); }
+
+static void outOfMemory( Compiler cc )
+{ fprintf(cc->listing,"Out of memory error at line %d\n",cc->lineno);
+  exit(1);
+}
+
+static void grow( Compiler cc, struct InternTableRec * names )
+{ int i, n = names->tableSize ? 2*names->tableSize : 1024;
+  InternEntry * t = (InternEntry *) calloc(n,sizeof(InternEntry));
+  InternEntry e, next;
+  if (t == NULL) outOfMemory(cc);
+  for (i = 0; i < names->tableSize; i++)
+    for (e = names->table[i]; e != NULL; e = next)
+    { next = e->next;
+      e->next = t[bucketOf(e->hash,n)];
+      t[bucketOf(e->hash,n)] = e;
+    }
+  free(names->table);
+  names->table = t;
+  names->tableSize = n;
+}
+
+char * intern( Compiler cc, const char * s )
+{ return internSpan(cc,s,strlen(s)); }
+
+char * internSpan( Compiler cc, const char * s, int len )
+{ struct InternTableRec * names = cc->names;
+  int h = 0, i;
+  InternEntry e;
+  if (names == NULL)
+  { names = cc->names = (struct InternTableRec *) calloc(1,sizeof(struct InternTableRec));
+    if (names == NULL) outOfMemory(cc);
+  }
+  for (i = 0; i < len; i++)
+    h = ((h << 4) + s[i]) % INTERN_MOD;
+  if (names->count >= names->tableSize) grow(cc,names);
+  i = bucketOf(h,names->tableSize);
+  for (e = names->table[i]; e != NULL; e = e->next)
+    if ((e->hash == h) && (e->len == len) && (memcmp(e->str,s,len) == 0))
+      return e->str;
+  e = (InternEntry) arenaAlloc(cc,offsetof(struct InternRec,str)+len+1,ArenaString);
+  e->hash = h;
+  e->len = len;
+  memcpy(e->str,s,len);
+  e->str[len] = '\0';
+  e->next = names->table[i];
+  names->table[i] = e;
+  names->count++;
+  return e->str;
+}
+
+void internFree( Compiler cc )
+{ if (cc->names == NULL) return;
+  free(cc->names->table);
+  free(cc->names);
+  cc->names = NULL;
+}
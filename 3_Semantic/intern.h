@@ -0,0 +1,44 @@
+/****************************************************/
+/* File: intern.h                                   */
+/* Identifier interning for the C-MINUS compiler    */
+/****************************************************/
+
+#ifndef _INTERN_H_
+#define _INTERN_H_
+
+#include <stddef.h>
+
+/* An interned string carries the hash
+ *   h = (h * 16 + c) mod INTERN_MOD
+ * over its characters
+ */
+#define INTERN_MOD (211 * 4096)
+
+typedef struct InternRec
+{ struct InternRec * next; /* chain in the intern table */
+  int hash;
+  int len;
+  char str[1];
+} * InternEntry;
+
+/* Function intern returns the single stored copy
+ * of string s in compilation cc; equal strings
+ * give equal pointers
+ */
+char * intern( Compiler cc, const char * s );
+
+/* Function internSpan interns the len chars at s,
+ * which need not be terminated
+ */
+char * internSpan( Compiler cc, const char * s, int len );
+
+/* Procedure internFree releases the table of cc;
+ * the strings themselves live in its arena
+ */
+void internFree( Compiler cc );
+
+/* internHash is the hash of interned string s */
+#define internHash(s) \
+  (((InternEntry) ((s) - offsetof(struct InternRec,str)))->hash)
+
+#endif
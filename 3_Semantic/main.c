@@ -5,36 +5,9 @@
 /* Kenneth C. Louden                                */
 /****************************************************/
 
+#include <unistd.h>
 #include "globals.h"
-
-/* set NO_PARSE to TRUE to get a scanner-only compiler */
-#define NO_PARSE FALSE
-/* set NO_ANALYZE to TRUE to get a parser-only compiler */
-#define NO_ANALYZE FALSE
-
-/* set NO_CODE to TRUE to get a compiler that does not
- * generate code
- */
-#define NO_CODE TRUE
-
-#include "util.h"
-#if NO_PARSE
-#include "scan.h"
-#else
-#include "parse.h"
-#if !NO_ANALYZE
-#include "analyze.h"
-#if !NO_CODE
-#include "cgen.h"
-#endif
-#endif
-#endif
-
-/* allocate global variables */
-int lineno = 0;
-FILE *source;
-FILE *listing;
-FILE *code;
+#include "driver.h"
 
 /* allocate and set tracing flags */
 int EchoSource = FALSE;
@@ -42,73 +15,114 @@ int TraceScan = FALSE;
 int TraceParse = FALSE;
 int TraceAnalyze = TRUE;
 int TraceCode = FALSE;
+int BinaryCode = FALSE;
+int OptimizeCode = FALSE;
+int TraceMemory = FALSE;
+int FuseAnalysis = FALSE;
+int MapSource = TRUE;
+int TableScan = TRUE;
+int BatchTokens = TRUE;
+int PipelineScan = FALSE;
+int ParseThreads = 1;
+int AnalyzeThreads = 1;
 
-int Error = FALSE;
+/* the programs named on the command line */
+static char **pgms = NULL;
+static int nPgms = 0;
+static int maxPgms = 0;
 
-main(int argc, char *argv[])
+/* addProgram appends the source file name to pgms,
+ * with the default extension if it has none
+ */
+static void addProgram(const char *name)
 {
-  TreeNode *syntaxTree;
-  char pgm[120]; /* source code file name */
-  if (argc != 2)
+  char *pgm = (char *)malloc(strlen(name) + 5);
+  if (nPgms == maxPgms)
+  {
+    maxPgms = maxPgms ? 2 * maxPgms : 16;
+    pgms = (char **)realloc(pgms, maxPgms * sizeof(char *));
+  }
+  if ((pgm == NULL) || (pgms == NULL))
   {
-    fprintf(stderr, "usage: %s <filename>\n", argv[0]);
+    fprintf(stderr, "Out of memory error in main\n");
     exit(1);
   }
-  strcpy(pgm, argv[1]);
+  strcpy(pgm, name);
   if (strchr(pgm, '.') == NULL)
     strcat(pgm, ".tny");
-  source = fopen(pgm, "r");
-  if (source == NULL)
+  pgms[nPgms++] = pgm;
+}
+
+/* addProgramList appends the file names listed in
+ * file, one per line
+ */
+static void addProgramList(const char *file)
+{
+  char line[1024];
+  int len;
+  FILE *list = fopen(file, "r");
+  if (list == NULL)
   {
-    fprintf(stderr, "File %s not found\n", pgm);
+    fprintf(stderr, "File %s not found\n", file);
     exit(1);
   }
-  listing = stdout; /* send listing to screen */
-  fprintf(listing, "\nC-MINUS COMPILATION: %s\n", pgm);
-#if NO_PARSE
-  while (getToken() != ENDFILE)
-    ;
-#else
-  syntaxTree = parse();
-  if (TraceParse)
+  while (fgets(line, sizeof(line), list))
   {
-    fprintf(listing, "\nSyntax tree:\n");
-    printTree(syntaxTree);
+    len = strcspn(line, "\r\n");
+    line[len] = '\0';
+    if (len > 0)
+      addProgram(line);
   }
-#if !NO_ANALYZE
-  if (!Error)
+  fclose(list);
+}
+
+/* usage: cminus [-O] [-s] [-p pieces] [-a threads] [-j threads]
+ *               <filename>...
+ * -O runs the peephole optimizer on the code;
+ * -s scans each source on a thread of its own;
+ * -p parses a large source in up to pieces parts
+ * on threads;
+ * -a analyzes the function bodies of a large
+ * program on threads;
+ * an argument @file names a file listing programs;
+ * several programs are compiled on threads workers
+ * (default: one per core), their listings written
+ * in order; the exit status is 1 if any program
+ * failed to compile
+ */
+int main(int argc, char *argv[])
+{
+  int nThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  int i, failed;
+  for (i = 1; i < argc; i++)
   {
-    // fprintf(listing, "\n");
-    buildSymtab(syntaxTree);
-    typeCheck(syntaxTree);
-    if (TraceAnalyze && !Error)
-    {
-      fprintf(listing, "\nBuilding Symbol Table...\n");
-      printSymTab(listing);
-      fprintf(listing, "\nChecking Types...\n");
-      fprintf(listing, "\nType Checking Finished\n\n");
-    }
+    if (strcmp(argv[i], "-O") == 0)
+      OptimizeCode = TRUE;
+    else if (strcmp(argv[i], "-s") == 0)
+      PipelineScan = TRUE;
+    else if ((strcmp(argv[i], "-p") == 0) && (i + 1 < argc))
+      ParseThreads = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-a") == 0) && (i + 1 < argc))
+      AnalyzeThreads = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-j") == 0) && (i + 1 < argc))
+      nThreads = atoi(argv[++i]);
+    else if (argv[i][0] == '@')
+      addProgramList(argv[i] + 1);
+    else
+      addProgram(argv[i]);
   }
-#if !NO_CODE
-  if (!Error)
+  if ((nPgms == 0) || (nThreads < 1) || (ParseThreads < 1) || (AnalyzeThreads < 1))
   {
-    char *codefile;
-    int fnlen = strcspn(pgm, ".");
-    codefile = (char *)calloc(fnlen + 4, sizeof(char));
-    strncpy(codefile, pgm, fnlen);
-    strcat(codefile, ".tm");
-    code = fopen(codefile, "w");
-    if (code == NULL)
-    {
-      printf("Unable to open %s\n", codefile);
-      exit(1);
-    }
-    codeGen(syntaxTree, codefile);
-    fclose(code);
+    fprintf(stderr, "usage: %s [-O] [-s] [-p pieces] [-a threads] [-j threads] <filename>...\n", argv[0]);
+    exit(1);
   }
-#endif
-#endif
-#endif
-  fclose(source);
-  return 0;
+  /* send listing to screen */
+  if (nPgms == 1)
+    failed = !compileFile(pgms[0], stdout);
+  else
+    failed = compileFiles(pgms, nPgms, nThreads, stdout);
+  for (i = 0; i < nPgms; i++)
+    free(pgms[i]);
+  free(pgms);
+  return failed ? 1 : 0;
 }
@@ -9,8 +9,16 @@
 #define _PARSE_H_
 
 /* Function parse returns the newly 
- * constructed syntax tree
+ * constructed syntax tree of the source
+ * of cc
  */
-TreeNode * parse(void);
+TreeNode * parse(Compiler cc);
+
+/* Function parseParallel returns the syntax tree
+ * parse would, parsing a large mapped source in
+ * pieces of top-level declarations on up to
+ * nThreads threads; the tokens are scanned first
+ */
+TreeNode * parseParallel(Compiler cc, int nThreads);
 
 #endif
@@ -0,0 +1,319 @@
+/****************************************************/
+/* File: peep.c                                     */
+/* Peephole optimizer for the TM code               */
+/* of the C-MINUS compiler                          */
+/****************************************************/
+
+#include "globals.h"
+#include "peep.h"
+
+/* The optimizer relies on two conventions of the
+ * code generator:
+ * - code addresses are only formed pc-relative
+ *   (emitRM_Abs, backpatched jumps), so every jump
+ *   target and return point is visible here;
+ * - memory based on mp holds temporaries and the
+ *   arguments of calls; a temporary loaded back in
+ *   the block that stored it is not read again, and
+ *   no other base register reaches that memory
+ *   within the block.
+ */
+
+/* an instruction being optimized; a pc-relative
+   operand is kept as an absolute target so that
+   instructions can be deleted */
+typedef struct
+{ TMCode c;
+  int target; /* target location, -1 if none */
+  int dead;   /* TRUE once deleted */
+} PeepInst;
+
+/* the state of one run of the optimizer */
+typedef struct
+{ PeepInst * ins;
+  int nIns;
+
+  /* isTarget[loc] is TRUE if some instruction
+     refers to location loc */
+  int * isTarget;
+
+  /* moveTo[loc] is the location loc moves to
+     when the deleted instructions are dropped */
+  int * moveTo;
+} Peep;
+
+/* the helpers below work on the state pp */
+#define ins (pp->ins)
+#define nIns (pp->nIns)
+#define isTarget (pp->isTarget)
+#define moveTo (pp->moveTo)
+
+#define OP(i) (ins[i].c.inst.iop)
+#define RR(i) (ins[i].c.inst.iarg1)
+#define RS(i) (ins[i].c.inst.iarg2) /* d for RM/RA */
+#define RT(i) (ins[i].c.inst.iarg3) /* s for RM/RA */
+
+/* isJump is TRUE for the conditional jumps */
+static int isJump( Peep * pp, int i )
+{ return OP(i) >= tmoJLT; }
+
+/* written returns the register written by
+   instruction i, -1 if none */
+static int written( Peep * pp, int i )
+{ switch (OP(i))
+  { case tmoIN: case tmoADD: case tmoSUB: case tmoMUL: case tmoDIV:
+    case tmoLD: case tmoLDA: case tmoLDC:
+      return RR(i);
+    default:
+      return -1;
+  }
+}
+
+/* readsReg is TRUE if instruction i reads register r */
+static int readsReg( Peep * pp, int i, int r )
+{ switch (OP(i))
+  { case tmoADD: case tmoSUB: case tmoMUL: case tmoDIV:
+      return (RS(i) == r) || (RT(i) == r);
+    case tmoOUT:
+      return RR(i) == r;
+    case tmoLD: case tmoLDA:
+      return RT(i) == r;
+    case tmoST:
+      return (RR(i) == r) || (RT(i) == r);
+    case tmoHALT: case tmoIN: case tmoLDC:
+      return FALSE;
+    default: /* conditional jumps */
+      return (RR(i) == r) || (RT(i) == r);
+  }
+}
+
+/* isGoto is TRUE if control never falls through
+   instruction i */
+static int isGoto( Peep * pp, int i )
+{ return (OP(i) == tmoHALT) || (written(pp,i) == pc); }
+
+/* endsBlock is TRUE if instruction i may transfer
+   control elsewhere */
+static int endsBlock( Peep * pp, int i )
+{ return isGoto(pp,i) || isJump(pp,i); }
+
+/* isPure is TRUE if instruction i only writes a
+   register and cannot fault in a correct program */
+static int isPure( Peep * pp, int i )
+{ switch (OP(i))
+  { case tmoADD: case tmoSUB: case tmoMUL:
+    case tmoLD: case tmoLDA: case tmoLDC:
+      return RR(i) != pc;
+    default:
+      return FALSE;
+  }
+}
+
+/* kill deletes instruction i */
+static int kill( Peep * pp, int i )
+{ ins[i].dead = TRUE;
+  return TRUE;
+}
+
+/* nextLive returns the first undeleted
+   instruction after i, nIns if none */
+static int nextLive( Peep * pp, int i )
+{ for (i++; (i < nIns) && ins[i].dead; i++) ;
+  return i;
+}
+
+/* prevLive returns the last undeleted
+   instruction before i, -1 if none */
+static int prevLive( Peep * pp, int i )
+{ for (i--; (i >= 0) && ins[i].dead; i--) ;
+  return i;
+}
+
+/* deadAfter is TRUE if the value of register r
+   after instruction i is never read; registers
+   are assumed live at the end of a block */
+static int deadAfter( Peep * pp, int i, int r )
+{ for (i = nextLive(pp,i); i < nIns; i = nextLive(pp,i))
+  { if (isTarget[i] || readsReg(pp,i,r)) return FALSE;
+    if (written(pp,i) == r) return TRUE;
+    if (endsBlock(pp,i)) return FALSE;
+  }
+  return FALSE;
+}
+
+static void markTargets( Peep * pp )
+{ int i;
+  for (i = 0; i <= nIns; i++) isTarget[i] = FALSE;
+  isTarget[0] = TRUE;
+  for (i = 0; i < nIns; i++)
+    if (ins[i].target >= 0) isTarget[ins[i].target] = TRUE;
+}
+
+/* removeUnreachable deletes the instructions after
+   an unconditional transfer up to the next target */
+static int removeUnreachable( Peep * pp )
+{ int i, reached = TRUE, changed = FALSE;
+  for (i = 0; i < nIns; i++)
+  { if (isTarget[i]) reached = TRUE;
+    if (!reached) changed = kill(pp,i);
+    else if (isGoto(pp,i)) reached = FALSE;
+  }
+  return changed;
+}
+
+/* threadJumps shortens jumps to jumps and deletes
+   jumps to the next instruction */
+static int threadJumps( Peep * pp )
+{ int i, t, changed = FALSE;
+  for (i = 0; i < nIns; i++)
+  { if (ins[i].dead || (ins[i].target < 0)) continue;
+    if (!isJump(pp,i) && !((OP(i) == tmoLDA) && (RR(i) == pc))) continue;
+    t = ins[i].target;
+    if ((t < nIns) && !ins[t].dead && (OP(t) == tmoLDA) && (RR(t) == pc) &&
+        (ins[t].target >= 0) && (ins[t].target != t) &&
+        (ins[t].target != ins[i].target))
+    { ins[i].target = ins[t].target;
+      changed = TRUE;
+    }
+    if (nextLive(pp,i) == ins[i].target) changed = kill(pp,i);
+  }
+  return changed;
+}
+
+/* forwardTemps replaces a push ST a,k(mp) and
+   its pop LD c,k(mp) in the same block by a
+   register move, or by nothing when c is a */
+static int forwardTemps( Peep * pp )
+{ int i, j, k, a, c, changed = FALSE;
+  for (i = 0; i < nIns; i++)
+  { if (ins[i].dead || (OP(i) != tmoST) || (RT(i) != mp) ||
+        (RR(i) == pc))
+      continue;
+    for (j = nextLive(pp,i); j < nIns; j = nextLive(pp,j))
+    { if (isTarget[j] || endsBlock(pp,j) || (written(pp,j) == mp)) break;
+      if (((OP(j) == tmoLD) || (OP(j) == tmoST)) &&
+          (RT(j) == mp) && (RS(j) == RS(i)))
+        break;
+    }
+    if ((j == nIns) || isTarget[j] || (OP(j) != tmoLD) ||
+        (RT(j) != mp) || (RS(j) != RS(i)))
+      continue;
+    c = RR(j);
+    if ((c == pc) || (c == mp)) continue;
+    for (k = nextLive(pp,i); k < j; k = nextLive(pp,k))
+      if (readsReg(pp,k,c) || (written(pp,k) == c)) break;
+    if (k < j) continue;
+    a = RR(i);
+    if (c == a) kill(pp,i);
+    else
+    { OP(i) = tmoLDA;
+      RR(i) = c;
+      RS(i) = 0;
+      RT(i) = a;
+    }
+    changed = kill(pp,j);
+  }
+  return changed;
+}
+
+/* propagateMoves folds a move LDA c,0(a) into
+   the instruction before it that computes a */
+static int propagateMoves( Peep * pp )
+{ int i, j, a, c, changed = FALSE;
+  for (j = 0; j < nIns; j++)
+  { if (ins[j].dead || (OP(j) != tmoLDA) || (RS(j) != 0)) continue;
+    a = RT(j);
+    c = RR(j);
+    if ((a == pc) || (c == pc)) continue;
+    if (a == c)
+    { changed = kill(pp,j);
+      continue;
+    }
+    i = prevLive(pp,j);
+    if ((i < 0) || isTarget[j] || (written(pp,i) != a) || endsBlock(pp,i))
+      continue;
+    if (OP(i) == tmoLDC)
+    { OP(j) = tmoLDC;
+      RS(j) = RS(i);
+      RT(j) = 0;
+      changed = TRUE;
+    }
+    else if (deadAfter(pp,j,a))
+    { RR(i) = c;
+      changed = kill(pp,j);
+    }
+  }
+  return changed;
+}
+
+/* removeDeadWrites deletes pure instructions
+   whose result is overwritten before it is read */
+static int removeDeadWrites( Peep * pp )
+{ int i, changed = FALSE;
+  for (i = 0; i < nIns; i++)
+    if (!ins[i].dead && isPure(pp,i) && deadAfter(pp,i,RR(i)))
+      changed = kill(pp,i);
+  return changed;
+}
+
+/* compact drops the deleted instructions and
+   relocates the targets and newLoc */
+static void compact( Peep * pp, int * newLoc, int n )
+{ int i, m = 0;
+  for (i = 0; i < nIns; i++)
+  { moveTo[i] = m;
+    if (!ins[i].dead) m++;
+  }
+  moveTo[nIns] = m;
+  for (i = 0; i <= n; i++) newLoc[i] = moveTo[newLoc[i]];
+  m = 0;
+  for (i = 0; i < nIns; i++)
+    if (!ins[i].dead)
+    { ins[m] = ins[i];
+      if (ins[m].target >= 0) ins[m].target = moveTo[ins[m].target];
+      m++;
+    }
+  nIns = m;
+}
+
+int peephole( Compiler cc, TMCode * buf, int n, int * newLoc )
+{ Peep peep, * pp = &peep;
+  int i, t, changed;
+  ins = malloc((n+1)*sizeof(PeepInst));
+  isTarget = malloc((n+1)*sizeof(int));
+  moveTo = malloc((n+1)*sizeof(int));
+  if ((ins == NULL) || (isTarget == NULL) || (moveTo == NULL))
+  { fprintf(cc->listing,"Out of memory error in peephole optimizer\n");
+    exit(1);
+  }
+  nIns = n;
+  for (i = 0; i < n; i++)
+  { ins[i].c = buf[i];
+    ins[i].c.used = TRUE; /* a hole executes as HALT */
+    ins[i].dead = FALSE;
+    ins[i].target = -1;
+    if ((OP(i) > tmoRRLim) && (OP(i) != tmoLDC) && (RT(i) == pc))
+    { t = i + 1 + RS(i);
+      if ((t >= 0) && (t <= n)) ins[i].target = t;
+    }
+  }
+  for (i = 0; i <= n; i++) newLoc[i] = i;
+  do
+  { markTargets(pp);
+    changed = removeUnreachable(pp);
+    changed |= threadJumps(pp);
+    changed |= forwardTemps(pp);
+    changed |= propagateMoves(pp);
+    changed |= removeDeadWrites(pp);
+    if (changed) compact(pp,newLoc,n);
+  } while (changed);
+  for (i = 0; i < nIns; i++)
+  { buf[i] = ins[i].c;
+    if (ins[i].target >= 0)
+      buf[i].inst.iarg2 = ins[i].target - (i + 1);
+  }
+  free(ins);
+  free(isTarget);
+  free(moveTo);
+  return nIns;
+}
@@ -0,0 +1,21 @@
+/****************************************************/
+/* File: peep.h                                     */
+/* Peephole optimizer interface for the TM code     */
+/* of the C-MINUS compiler                          */
+/****************************************************/
+
+#ifndef _PEEP_H_
+#define _PEEP_H_
+
+#include "code.h"
+
+/* Function peephole optimizes the n locations of
+ * the code buffer buf in place and returns the new
+ * number of locations; newLoc (n+1 entries) receives
+ * the location each old location moved to, where a
+ * deleted location moves to the instruction that
+ * followed it; cc receives the error messages
+ */
+int peephole( Compiler cc, TMCode * buf, int n, int * newLoc );
+
+#endif
@@ -0,0 +1,130 @@
+/****************************************************/
+/* File: pparse.c                                   */
+/* Parallel parsing for the C-MINUS compiler: a     */
+/* large source is split between its top-level      */
+/* declarations into pieces that are parsed on      */
+/* threads of their own                             */
+/****************************************************/
+
+#include <pthread.h>
+#include "globals.h"
+#include "scan.h"
+#include "parse.h"
+#include "arena.h"
+#include "compiler.h"
+
+/* PARSEMIN = the number of tokens of the smallest
+   source that is parsed in pieces */
+#define PARSEMIN 65536
+
+/* a piece of the source: tokens [from,to) of it,
+   parsed in a context of its own */
+typedef struct
+{ Compiler cc;
+  char * listing; /* what the parser of the piece printed */
+  size_t listingSize;
+  int from, to;
+  TreeNode * tree;
+  pthread_t thread;
+  int started; /* TRUE if the piece has a thread */
+} PieceRec;
+
+static void * parsePiece( void * arg )
+{ PieceRec * p = (PieceRec *) arg;
+  p->tree = parse(p->cc);
+  return NULL;
+}
+
+/* splitTokens splits the n tokens before ENDFILE
+   into at most max pieces of about equal numbers
+   of tokens, each ending where a declaration at
+   the top level does, and returns their number */
+static int splitTokens( const TokenRec * tokens, int n, PieceRec * pieces,
+                        int max )
+{ int i, depth = 0, from = 0, nPieces = 0;
+  for (i = 0; (i < n) && (nPieces < max - 1); i++)
+  { switch (tokens[i].kind)
+    { case LCURLY: depth++; continue;
+      case RCURLY: depth--; break;
+      case SEMI: break;
+      default: continue;
+    }
+    if ((depth == 0) && (i + 1 - from >= n / max) && (i + 1 < n))
+    { pieces[nPieces].from = from;
+      pieces[nPieces++].to = from = i + 1;
+    }
+  }
+  pieces[nPieces].from = from;
+  pieces[nPieces++].to = n;
+  return nPieces;
+}
+
+/* parseReplay parses the tokens of cc replayed,
+   as parse would have parsed the source */
+static TreeNode * parseReplay( Compiler cc, const TokenRec * tokens, int n,
+                               const char * text )
+{ replayTokens(cc,tokens,n,text);
+  return parse(cc);
+}
+
+TreeNode * parseParallel( Compiler cc, int nThreads )
+{ TokenRec * tokens;
+  const char * text;
+  PieceRec * pieces;
+  TreeNode * tree, * last;
+  int n, i, nPieces, ok = TRUE;
+  /* a trace of the tokens must come as they are
+     parsed */
+  if ((nThreads < 2) || EchoSource || TraceScan) return parse(cc);
+  tokens = scanAll(cc,&n,&text);
+  if (tokens == NULL) return parse(cc);
+  /* tokens[n-1] is the ENDFILE of the source */
+  pieces = (n >= PARSEMIN) ? calloc(nThreads,sizeof(PieceRec)) : NULL;
+  if (pieces == NULL)
+  { tree = parseReplay(cc,tokens,n,text);
+    free(tokens);
+    return tree;
+  }
+  nPieces = splitTokens(tokens,n - 1,pieces,nThreads);
+  for (i = 0; i < nPieces; i++)
+  { FILE * listing = open_memstream(&pieces[i].listing,&pieces[i].listingSize);
+    if (listing == NULL)
+    { fprintf(cc->listing,"Out of memory error in the parser\n");
+      exit(1);
+    }
+    pieces[i].cc = newCompiler(NULL,listing);
+    replayTokens(pieces[i].cc,tokens + pieces[i].from,
+                 pieces[i].to - pieces[i].from,text);
+  }
+  /* the first piece is parsed on this thread, and
+     so is any other whose thread fails to start */
+  for (i = 1; i < nPieces; i++)
+    pieces[i].started =
+      (pthread_create(&pieces[i].thread,NULL,parsePiece,&pieces[i]) == 0);
+  for (i = 0; i < nPieces; i++)
+  { if (pieces[i].started) pthread_join(pieces[i].thread,NULL);
+    else parsePiece(&pieces[i]);
+    ok = ok && !pieces[i].cc->Error && (pieces[i].tree != NULL);
+  }
+  /* the declarations of the pieces are linked in
+     source order, their nodes moved to cc */
+  tree = last = NULL;
+  for (i = 0; i < nPieces; i++)
+  { if (ok)
+    { arenaAdopt(cc,pieces[i].cc);
+      if (last == NULL) tree = pieces[i].tree;
+      else last->sibling = pieces[i].tree;
+      for (last = pieces[i].tree; last->sibling != NULL; last = last->sibling) ;
+    }
+    fclose(pieces[i].cc->listing);
+    free(pieces[i].listing);
+    freeCompiler(pieces[i].cc);
+  }
+  free(pieces);
+  /* a piece in error is parsed again as part of
+     the whole, for the same messages */
+  if (ok) cc->savedTree = tree;
+  else tree = parseReplay(cc,tokens,n,text);
+  free(tokens);
+  return tree;
+}
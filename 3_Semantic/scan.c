@@ -5,101 +5,385 @@
 /* Kenneth C. Louden                                */
 /****************************************************/
 
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "globals.h"
 #include "util.h"
 #include "scan.h"
+#include "span.h"
+
+/* the token of the blanks and comments that the
+   table-driven DFA skips, and the run of the states
+   that loop on no run of chars */
+#define DFA_SKIP (-1)
+#define DFA_NORUN (-1)
+#include "scandfa.h"
 
 /* states in scanner DFA */
 typedef enum
    { START,INEQ,INCOMMENT,INNUM,INID,DONE,INLT,INGT,INNE,INOVER,INCOMMENT_ }
    StateType;
 
-/* lexeme of identifier or reserved word */
-char tokenString[MAXTOKENLEN+1];
-
-/* BUFLEN = length of the input buffer for
-   source code lines */
-#define BUFLEN 256
-
-static char lineBuf[BUFLEN]; /* holds the current line */
-static int linepos = 0; /* current position in LineBuf */
-static int bufsize = 0; /* current size of buffer string */
-static int EOF_flag = FALSE; /* corrects ungetNextChar behavior on EOF */
-
-/* getNextChar fetches the next non-blank character
-   from lineBuf, reading in a new line if lineBuf is
-   exhausted */
-static int getNextChar(void)
-{ if (!(linepos < bufsize))
-  { lineno++;
-    if (fgets(lineBuf,BUFLEN-1,source))
-    { if (EchoSource) fprintf(listing,"%4d: %s",lineno,lineBuf);
-      bufsize = strlen(lineBuf);
-      linepos = 0;
-      return lineBuf[linepos++];
+/* BUFLEN = size of the blocks in which the
+   source is read when it is not mapped */
+#define BUFLEN 65536
+
+/* TOKENBATCH = number of tokens the scanner
+   queues at a time in batch mode, and the size
+   of the queue of a pipeline */
+#define TOKENBATCH 256
+
+/* PIPEMIN = the size of the smallest source that
+   is scanned on a thread of its own */
+#define PIPEMIN 1048576
+
+/* the scanner state of one compilation,
+   created by the first call of getToken */
+typedef struct ScannerRec
+   { /* the source text at hand is buf[0..size-1];
+        it is the whole source when the source is
+        mapped, and else the last block read, after
+        the part of the token being scanned kept
+        from the blocks before */
+     char * buf;
+     int pos; /* position of the next char in buf */
+     int size; /* end of the text in buf */
+     int cap; /* size of the block buffer */
+     int start; /* start of the token being scanned, -1 if none */
+     char * map; /* the mapped source, NULL if none */
+     int EOF_flag; /* corrects ungetNextChar behavior on EOF */
+     int newLine; /* TRUE if the next char starts a line */
+     int echoing; /* TRUE if a line echoed is not done */
+     long base; /* offset of buf[0] in the source */
+     /* the ring of tokens queued, and lineno as
+        the scanner has counted it in batch mode */
+     TokenRec ring[TOKENBATCH];
+     unsigned head; /* the number of tokens handed out */
+     unsigned tail; /* the number of tokens queued */
+     int lineno;
+     /* a pipeline scans on the thread producer in a
+        context of its own, and queues the tokens for
+        the parser thread; head and tail are then
+        only accessed atomically */
+     int piped; /* TRUE if the producer runs */
+     int stop; /* set to stop the producer */
+     pthread_t producer;
+     struct CompilerRec scanCC;
+     /* the tokens replayed by replayTokens, their
+        number and the number handed out, NULL if
+        none; their lexemes are in text */
+     const TokenRec * replay;
+     int replayCount;
+     int replayed;
+     const char * text;
+   } * Scanner;
+
+static void outOfMemory(Compiler cc)
+{ fprintf(cc->listing,"Out of memory error in the scanner\n");
+  exit(1);
+}
+
+/* mapSource maps the rest of the source of cc
+   for sc if MapSource is set and the source is a
+   regular file, returning TRUE on success */
+static int mapSource(Compiler cc, Scanner sc)
+{ struct stat st;
+  long off;
+  int fd = fileno(cc->source);
+  char * map;
+  if (!MapSource || (fstat(fd,&st) != 0) || !S_ISREG(st.st_mode) ||
+      (st.st_size == 0) || (st.st_size > INT_MAX))
+    return FALSE;
+  off = ftell(cc->source);
+  if ((off < 0) || (off > st.st_size)) return FALSE;
+  map = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+  if (map == MAP_FAILED) return FALSE;
+  sc->map = sc->buf = map;
+  sc->size = (int) st.st_size;
+  sc->pos = (int) off;
+  return TRUE;
+}
+
+static void startPipe(Compiler cc, Scanner sc);
+
+static Scanner scannerOf(Compiler cc)
+{ Scanner sc = cc->scanner;
+  if (sc == NULL)
+  { sc = calloc(1,sizeof(struct ScannerRec));
+    if (sc == NULL) outOfMemory(cc);
+    sc->start = -1;
+    sc->newLine = TRUE;
+    if (!mapSource(cc,sc))
+    { sc->buf = malloc(BUFLEN);
+      if (sc->buf == NULL) outOfMemory(cc);
+      sc->cap = BUFLEN;
     }
-    else
-    { EOF_flag = TRUE;
-      return EOF;
+    else if (PipelineScan && !EchoSource && (sc->size - sc->pos >= PIPEMIN))
+      startPipe(cc,sc);
+    cc->scanner = sc;
+  }
+  return sc;
+}
+
+/* echoLine echoes to the listing the rest of the
+   line that starts at p, up to the end of the block */
+static void echoLine(Compiler cc, Scanner sc, char * p)
+{ char * end = sc->buf + sc->size;
+  char * q = memchr(p,'\n',end - p);
+  sc->echoing = (q == NULL);
+  fwrite(p,1,(sc->echoing ? end : q + 1) - p,cc->listing);
+}
+
+/* fill reads the next block of the source,
+   returning FALSE at the end of the source; the
+   token being scanned moves to the front of buf,
+   or else the last char, for ungetNextChar, but
+   after the lexemes of the tokens queued */
+static int fill(Compiler cc, Scanner sc)
+{ int from, n;
+  if (sc->map != NULL) return FALSE;
+  from = (sc->start >= 0) ? sc->start : (sc->size > 0) ? sc->size - 1 : 0;
+  if ((sc->tail != sc->head) &&
+      (sc->ring[sc->head % TOKENBATCH].offset - sc->base < from))
+    from = (int) (sc->ring[sc->head % TOKENBATCH].offset - sc->base);
+  sc->base += from;
+  memmove(sc->buf,sc->buf+from,sc->size-from);
+  sc->size -= from;
+  sc->pos -= from;
+  if (sc->start >= 0) sc->start -= from;
+  if (sc->cap - sc->size < BUFLEN/2)
+  { /* a long token */
+    sc->cap *= 2;
+    sc->buf = realloc(sc->buf,sc->cap);
+    if (sc->buf == NULL) outOfMemory(cc);
+  }
+  n = fread(sc->buf+sc->size,1,sc->cap-sc->size,cc->source);
+  sc->size += n;
+  if (sc->echoing) echoLine(cc,sc,sc->buf+sc->size-n);
+  return n > 0;
+}
+
+/* startChar is getNextChar at the end of a block
+   or the start of a line: it reads in a new block
+   if the block is exhausted, and advances lineno
+   by the first char of each line, as that line is
+   echoed */
+static int startChar(Compiler cc, Scanner sc)
+{ int c;
+  if ((sc->pos == sc->size) && !fill(cc,sc))
+  { if (sc->newLine) cc->lineno++;
+    sc->newLine = FALSE;
+    sc->EOF_flag = TRUE;
+    return EOF;
+  }
+  c = (unsigned char) sc->buf[sc->pos++];
+  if (sc->newLine)
+  { sc->newLine = FALSE;
+    cc->lineno++;
+    if (EchoSource)
+    { fprintf(cc->listing,"%4d: ",cc->lineno);
+      echoLine(cc,sc,sc->buf+sc->pos-1);
     }
   }
-  else return lineBuf[linepos++];
+  if (c == '\n') sc->newLine = TRUE;
+  return c;
+}
+
+/* getNextChar fetches the next character from
+   the current block */
+static int getNextChar(Compiler cc, Scanner sc)
+{ int c;
+  if ((sc->pos == sc->size) || sc->newLine) return startChar(cc,sc);
+  c = (unsigned char) sc->buf[sc->pos++];
+  if (c == '\n') sc->newLine = TRUE;
+  return c;
+}
+
+/* ungetNextChar backtracks one character in buf;
+   the char backed over is a lookahead that follows
+   part of a token, so it never starts a line and
+   fill has kept it */
+static void ungetNextChar(Scanner sc)
+{ if (!sc->EOF_flag)
+  { sc->pos--;
+    sc->newLine = FALSE;
+  }
+}
+
+/* advance moves the scanner past the chars up to p
+   in the current block, which hold nl newlines,
+   keeping lineno as getNextChar would */
+static void advance(Compiler cc, Scanner sc, char * p, int nl)
+{ if (p == sc->buf + sc->pos) return;
+  cc->lineno += sc->newLine + nl - (p[-1] == '\n');
+  sc->newLine = (p[-1] == '\n');
+  sc->pos = p - sc->buf;
+}
+
+/* isBlank is TRUE for the chars skipped between tokens */
+#define isBlank(c) (((c) == ' ') || ((c) == '\t') || ((c) == '\n'))
+
+/* the letters and digits of C-minus are ASCII,
+   whatever the locale */
+#define isLetter(c) ((unsigned) (((c) | 0x20) - 'a') < 26)
+#define isDigit(c) ((unsigned) ((c) - '0') < 10)
+
+/* skipBlanks skips a run of blanks in bulk; the
+   blanks are read one by one when echoing */
+static void skipBlanks(Compiler cc, Scanner sc)
+{ char * p, * end;
+  int nl;
+  if (EchoSource || (sc->pos == sc->size) || !isBlank(sc->buf[sc->pos]))
+    return;
+  do
+  { end = sc->buf + sc->size;
+    nl = 0;
+    p = (char *) spanRun(sc->buf + sc->pos,end,RunBlanks,&nl);
+    advance(cc,sc,p,nl);
+  } while ((p == end) && fill(cc,sc));
+}
+
+/* skipComment skips the text of a comment up to
+   the next '*' in bulk, counting its newlines */
+static void skipComment(Compiler cc, Scanner sc)
+{ char * q, * end;
+  int nl;
+  if (EchoSource) return;
+  do
+  { end = sc->buf + sc->size;
+    nl = 0;
+    q = (char *) spanRun(sc->buf + sc->pos,end,RunComment,&nl);
+    advance(cc,sc,q,nl);
+  } while ((q == end) && fill(cc,sc));
 }
 
-/* ungetNextChar backtracks one character
-   in lineBuf */
-static void ungetNextChar(void)
-{ if (!EOF_flag) linepos-- ;}
+/* skipRun skips the rest of a run of letters (or
+   of digits) in buf in bulk */
+static void skipRun(Scanner sc, int letters)
+{ int nl = 0;
+  const char * p = spanRun(sc->buf + sc->pos,sc->buf + sc->size,
+                           letters ? RunLetters : RunDigits,&nl);
+  sc->pos = p - sc->buf;
+}
 
 /* lookup table of reserved words */
 static struct
     { char* str;
       TokenType tok;
     } reservedWords[MAXRESERVED]
-   = {{"if",IF},{"else",ELSE},{"while",WHILE},{"return",RETURN},{"int",INT},{"void",VOID},
-      /* discarded */
-      {"then",THEN},{"end",END},
-      {"repeat",REPEAT},{"until",UNTIL},{"read",READ},
-      {"write",WRITE}};
+   = {{"if",IF},{"else",ELSE},{"while",WHILE},
+      {"return",RETURN},{"int",INT},{"void",VOID}};
 
-/* lookup an identifier to see if it is a reserved word */
+/* lookup an identifier of len chars at s to see
+   if it is a reserved word */
 /* uses linear search */
-static TokenType reservedLookup (char * s)
+static TokenType reservedLookup (const char * s, int len)
 { int i;
   for (i=0;i<MAXRESERVED;i++)
-    if (!strcmp(s,reservedWords[i].str))
+    if (!strncmp(s,reservedWords[i].str,len) &&
+        (reservedWords[i].str[len] == '\0'))
       return reservedWords[i].tok;
   return ID;
 }
 
-/****************************************/
-/* the primary function of the scanner  */
-/****************************************/
-/* function getToken returns the 
- * next token in source file
- */
-TokenType getToken(void)
-{  /* index for storing into tokenString */
-   int tokenStringIndex = 0;
-   /* holds current token to be returned */
+/* countLines advances lineno over the blanks and
+   comments in buf[from..to-1] as getNextChar would */
+static void countLines(Compiler cc, Scanner sc, int from, int to)
+{ char * end = sc->buf + to;
+  int nl = 0;
+  if (from >= to) return;
+  spanRun(sc->buf + from,end,RunAny,&nl);
+  cc->lineno += sc->newLine + nl - (end[-1] == '\n');
+  sc->newLine = (end[-1] == '\n');
+}
+
+/* tableToken is the table-driven core of getToken:
+   it runs the DFA of scandfa.h over buf, one table
+   lookup per char, until a char has no transition;
+   the token is then that of the state reached and
+   spans buf[start..pos-1]. The runs of chars that
+   a state loops on are skipped by spanRun instead.
+   Blanks and comments are matched as tokens
+   DFA_SKIP and skipped */
+static TokenType tableToken(Compiler cc, Scanner sc)
+{ const unsigned char * buf, * p, * end, * start;
+  int state = DFA_START, next, ok;
+  int nl = 0; /* the newlines of a gap are counted apart */
+  TokenType tok;
+  sc->start = sc->pos;
+  for (;;)
+  { buf = (const unsigned char *) sc->buf;
+    p = buf + sc->pos;
+    start = buf + sc->start;
+    end = buf + sc->size;
+    for (;;)
+    { while ((p < end) &&
+             ((next = dfaNext[state][dfaClass[*p]]) != DFA_DONE))
+      { state = next;
+        p++;
+        /* a run of chars the state loops on goes in bulk */
+        if (dfaRun[state] != DFA_NORUN)
+          p = (const unsigned char *) spanRun((const char *) p,
+                (const char *) end,(RunKind) dfaRun[state],&nl);
+      }
+      if ((p == end) || (dfaToken[state] != DFA_SKIP)) break;
+      /* skip the blanks or comment and start over */
+      countLines(cc,sc,start - buf,p - buf);
+      state = DFA_START;
+      start = p;
+    }
+    sc->pos = p - buf;
+    sc->start = start - buf;
+    if (p < end) break;
+    tok = dfaToken[state];
+    if ((tok == DFA_SKIP) || (tok == ENDFILE))
+    { /* blanks and comments are not kept by fill */
+      countLines(cc,sc,sc->start,sc->pos);
+      sc->start = -1;
+      ok = fill(cc,sc);
+      sc->start = sc->pos;
+    }
+    else ok = fill(cc,sc);
+    if (!ok) break;
+  }
+  tok = dfaToken[state];
+  if ((tok == DFA_SKIP) || (tok == ENDFILE))
+  { /* the end of the source */
+    countLines(cc,sc,sc->start,sc->pos);
+    tok = ENDFILE;
+  }
+  /* the first char of the token, or the end of
+     the source, may start a line */
+  if (sc->newLine) cc->lineno++;
+  sc->newLine = FALSE;
+  return tok;
+}
+
+/* switchToken is the hand-coded core of getToken,
+   which echoes the source */
+static TokenType switchToken(Compiler cc, Scanner sc)
+{  /* holds current token to be returned */
    TokenType currentToken;
    /* current state - always begins at START */
    StateType state = START;
-   /* flag to indicate save to tokenString */
-   int save;
    while (state != DONE)
-   { int c = getNextChar();
-     save = TRUE;
+   { int c = getNextChar(cc,sc);
      switch (state)
      { case START:
-         if (isdigit(c))
+         sc->start = sc->pos - 1;
+         if (isDigit(c))
            state = INNUM;
-         else if (isalpha(c))
+         else if (isLetter(c))
            state = INID;
          else if (c == '=')
            state = INEQ;
-         else if ((c == ' ') || (c == '\t') || (c == '\n'))
-           save = FALSE;
+         else if (isBlank(c))
+         { sc->start = -1;
+           skipBlanks(cc,sc);
+         }
          else if (c == '!')
            state = INNE;
          else if (c == '<')
@@ -107,14 +391,11 @@ TokenType getToken(void)
          else if (c == '>')
            state = INGT;
          else if (c == '/')
-         { save = FALSE;
            state = INOVER;
-         }
          else
          { state = DONE;
            switch (c)
            { case EOF:
-               save = FALSE;
                currentToken = ENDFILE;
                break;
              case '=':
@@ -165,25 +446,25 @@ TokenType getToken(void)
        case INOVER:
          if (c == '*')
          { state = INCOMMENT;
-           save = FALSE;
+           sc->start = -1;
          }
          else
          { state = DONE;
-           ungetNextChar();
+           ungetNextChar(sc);
            currentToken = OVER;
          }
+         break;
        case INCOMMENT:
          //printf("%c.",c);
-         save = FALSE;
          if (c == EOF)
          { state = DONE;
            currentToken = ENDFILE;
          }
          else if (c == '*') state = INCOMMENT_;
+         else skipComment(cc,sc);
          break;
        case INCOMMENT_:
          //printf("%c'", c);
-         save = FALSE;
          if (c == EOF)
          { state = DONE;
            currentToken = ENDFILE;
@@ -197,7 +478,7 @@ TokenType getToken(void)
          if (c == '=')
            currentToken = LE;
          else
-         { ungetNextChar();
+         { ungetNextChar(sc);
            currentToken = LT;
          }  
          break;
@@ -206,7 +487,7 @@ TokenType getToken(void)
          if (c == '=')
            currentToken = GE;
          else
-         { ungetNextChar();
+         { ungetNextChar(sc);
            currentToken = GT;
          }
          break;
@@ -215,7 +496,7 @@ TokenType getToken(void)
          if (c == '=')
            currentToken = EQ;
          else
-         { ungetNextChar();
+         { ungetNextChar(sc);
            currentToken = ASSIGN;
          }
          break;
@@ -224,48 +505,248 @@ TokenType getToken(void)
          if (c == '=')
            currentToken = NE;
          else
-         { ungetNextChar();
-           save = FALSE;
+         { ungetNextChar(sc);
            currentToken = ERROR;
          }
          break;
        case INNUM:
-         if (!isdigit(c))
+         if (!isDigit(c))
          { /* backup in the input */
-           ungetNextChar();
-           save = FALSE;
+           ungetNextChar(sc);
            state = DONE;
            currentToken = NUM;
          }
          break;
        case INID:
-         if (!isalpha(c))
+         if (!isLetter(c))
          { /* backup in the input */
-           ungetNextChar();
-           save = FALSE;
+           ungetNextChar(sc);
            state = DONE;
            currentToken = ID;
          }
          break;
        case DONE:
        default: /* should never happen */
-         fprintf(listing,"Scanner Bug: state= %d\n",state);
+         fprintf(cc->listing,"Scanner Bug: state= %d\n",state);
          state = DONE;
          currentToken = ERROR;
          break;
      }
-     if ((save) && (tokenStringIndex <= MAXTOKENLEN))
-       tokenString[tokenStringIndex++] = (char) c;
-     if (state == DONE)
-     { tokenString[tokenStringIndex] = '\0';
-       if (currentToken == ID)
-         currentToken = reservedLookup(tokenString);
-     }
+     if ((state == INID) || (state == INNUM))
+       skipRun(sc,state == INID);
    }
+   if (currentToken == ID)
+     currentToken = reservedLookup(sc->buf + sc->start,sc->pos - sc->start);
+   return currentToken;
+}
+
+/* scanToken scans the next token with the core
+   selected, leaving its lexeme as a span of buf */
+static TokenType scanToken(Compiler cc, Scanner sc)
+{ TokenType currentToken;
+  if (TableScan && !EchoSource)
+    currentToken = tableToken(cc,sc);
+  else
+    currentToken = switchToken(cc,sc);
+  if (currentToken == ENDFILE)
+  { cc->lexeme = sc->buf + sc->pos;
+    cc->lexemeLength = 0;
+  }
+  else
+  { cc->lexeme = sc->buf + sc->start;
+    cc->lexemeLength = sc->pos - sc->start;
+  }
+  sc->start = -1;
+  return currentToken;
+}
+
+/* scanRecord scans the next token into t */
+static void scanRecord(Compiler cc, Scanner sc, TokenRec * t)
+{ t->kind = scanToken(cc,sc);
+  t->lineno = cc->lineno;
+  t->offset = sc->base + (cc->lexeme - sc->buf);
+  t->length = cc->lexemeLength;
+  if (t->kind == NUM) t->attr.val = lexemeNumber(cc);
+  else t->attr.name = NULL;
+}
+
+/* fillRing scans tokens in a tight loop until the
+   ring is full or the source ends, with the names
+   interned and the numbers converted on the way */
+static void fillRing(Compiler cc, Scanner sc)
+{ TokenRec * t;
+  cc->lineno = sc->lineno;
+  cc->tokenAttr = FALSE;
+  while (sc->tail - sc->head < TOKENBATCH)
+  { t = &sc->ring[sc->tail % TOKENBATCH];
+    scanRecord(cc,sc,t);
+    if (t->kind == ID) t->attr.name = lexemeName(cc);
+    /* fill keeps the lexeme from now on */
+    sc->tail++;
+    if (t->kind == ENDFILE) break;
+  }
+  sc->lineno = cc->lineno;
+}
+
+/* produce is the producer thread of a pipeline:
+   it scans the mapped source to its end, waiting
+   while the queue is full, unless stopped */
+static void * produce(void * arg)
+{ Scanner sc = (Scanner) arg;
+  TokenType kind;
+  unsigned tail = 0;
+  do
+  { while (tail - __atomic_load_n(&sc->head,__ATOMIC_ACQUIRE) == TOKENBATCH)
+    { if (__atomic_load_n(&sc->stop,__ATOMIC_ACQUIRE)) return NULL;
+      sched_yield();
+    }
+    scanRecord(&sc->scanCC,sc,&sc->ring[tail % TOKENBATCH]);
+    kind = sc->ring[tail % TOKENBATCH].kind;
+    __atomic_store_n(&sc->tail,++tail,__ATOMIC_RELEASE);
+  } while (kind != ENDFILE);
+  return NULL;
+}
+
+/* startPipe starts the producer of a pipeline for
+   the mapped source of sc; the tokens are then
+   batched on this thread if it fails to start */
+static void startPipe(Compiler cc, Scanner sc)
+{ sc->scanCC.source = cc->source;
+  sc->scanCC.listing = cc->listing;
+  sc->piped = (pthread_create(&sc->producer,NULL,produce,sc) == 0);
+}
+
+/* handOut makes the token of t, with its lexeme
+   at lexeme, the current token of cc */
+static TokenType handOut(Compiler cc, const TokenRec * t, const char * lexeme)
+{ cc->lineno = t->lineno;
+  cc->lexeme = lexeme;
+  cc->lexemeLength = t->length;
+  /* a pipeline leaves the names to lexemeName */
+  cc->tokenAttr = (t->kind == NUM) || ((t->kind == ID) && (t->attr.name != NULL));
+  if (t->kind == ID) cc->tokenName = t->attr.name;
+  else if (t->kind == NUM) cc->tokenValue = t->attr.val;
+  return t->kind;
+}
+
+/* popToken hands out the next token queued,
+   as getToken would have returned it */
+static TokenType popToken(Compiler cc, Scanner sc)
+{ TokenRec * t;
+  TokenType kind;
+  if (sc->piped)
+  { while (sc->head == __atomic_load_n(&sc->tail,__ATOMIC_ACQUIRE))
+      sched_yield();
+  }
+  else if (sc->head == sc->tail) fillRing(cc,sc);
+  t = &sc->ring[sc->head % TOKENBATCH];
+  kind = handOut(cc,t,sc->buf + (t->offset - sc->base));
+  /* t is free for the next token once handed out;
+     at the end of the source, ENDFILE stays */
+  if (kind != ENDFILE)
+  { if (sc->piped) __atomic_store_n(&sc->head,sc->head + 1,__ATOMIC_RELEASE);
+    else sc->head++;
+  }
+  return kind;
+}
+
+/* replayToken hands out the next token replayed;
+   past the last one, the source ends there */
+static TokenType replayToken(Compiler cc, Scanner sc)
+{ const TokenRec * t;
+  if (sc->replayed == sc->replayCount)
+  { cc->lexeme = "";
+    cc->lexemeLength = 0;
+    cc->tokenAttr = FALSE;
+    return ENDFILE;
+  }
+  t = &sc->replay[sc->replayed];
+  if (t->kind != ENDFILE) sc->replayed++;
+  return handOut(cc,t,sc->text + t->offset);
+}
+
+/****************************************/
+/* the primary function of the scanner  */
+/****************************************/
+/* function getToken returns the 
+ * next token in source file; its lexeme is
+ * left as a span of buf, without a copy
+ */
+TokenType getToken(Compiler cc)
+{  Scanner sc = scannerOf(cc);
+   TokenType currentToken;
+   if (sc->replay != NULL)
+     currentToken = replayToken(cc,sc);
+   else if (sc->piped || (BatchTokens && !EchoSource))
+     currentToken = popToken(cc,sc);
+   else
+     currentToken = scanToken(cc,sc);
    if (TraceScan) {
-     fprintf(listing,"\t%d: ",lineno);
-     printToken(currentToken,tokenString);
+     fprintf(cc->listing,"\t%d: ",cc->lineno);
+     printToken(cc,currentToken,lexemeString(cc));
    }
    return currentToken;
 } /* end getToken */
 
+/* SCANALLMIN = the number of tokens scanAll
+   makes room for at first */
+#define SCANALLMIN 65536
+
+TokenRec * scanAll(Compiler cc, int * n, const char ** text)
+{ Scanner sc = scannerOf(cc);
+  TokenRec * all = NULL, * t;
+  int cap = 0;
+  if (sc->map == NULL) return NULL;
+  *n = 0;
+  do
+  { if (*n == cap)
+    { cap = cap ? 2 * cap : SCANALLMIN;
+      t = realloc(all,cap * sizeof(TokenRec));
+      if (t == NULL)
+      { free(all);
+        outOfMemory(cc);
+      }
+      all = t;
+    }
+    t = &all[(*n)++];
+    t->kind = getToken(cc);
+    t->lineno = cc->lineno;
+    t->offset = cc->lexeme - sc->map;
+    t->length = cc->lexemeLength;
+    if (t->kind == ID) t->attr.name = lexemeName(cc);
+    else if (t->kind == NUM) t->attr.val = lexemeNumber(cc);
+    else t->attr.name = NULL;
+  } while (t->kind != ENDFILE);
+  *text = sc->map;
+  return all;
+}
+
+void replayTokens(Compiler cc, const TokenRec * tokens, int n,
+                  const char * text)
+{ Scanner sc = cc->scanner;
+  if (sc == NULL)
+  { sc = calloc(1,sizeof(struct ScannerRec));
+    if (sc == NULL) outOfMemory(cc);
+    sc->start = -1;
+    cc->scanner = sc;
+  }
+  sc->replay = tokens;
+  sc->replayCount = n;
+  sc->replayed = 0;
+  sc->text = text;
+}
+
+/* scanFree releases the scanner state of cc */
+void scanFree(Compiler cc)
+{ Scanner sc = cc->scanner;
+  if (sc == NULL) return;
+  if (sc->piped)
+  { /* the parser may have stopped early */
+    __atomic_store_n(&sc->stop,TRUE,__ATOMIC_RELEASE);
+    pthread_join(sc->producer,NULL);
+  }
+  if (sc->map != NULL) munmap(sc->map,sc->size);
+  else free(sc->buf);
+  free(sc);
+  cc->scanner = NULL;
+}
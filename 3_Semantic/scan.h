@@ -8,15 +8,45 @@
 #ifndef _SCAN_H_
 #define _SCAN_H_
 
-/* MAXTOKENLEN is the maximum size of a token */
-#define MAXTOKENLEN 40
-
-/* tokenString array stores the lexeme of each token */
-extern char tokenString[MAXTOKENLEN+1];
+/* a token scanned ahead of the parser */
+typedef struct
+   { TokenType kind;
+     int lineno; /* line of the token */
+     long offset; /* of the lexeme in the source */
+     int length; /* of the lexeme */
+     union
+       { char * name; /* of an ID, interned; NULL in a pipeline */
+         int val; /* of a NUM */
+       } attr;
+   } TokenRec;
 
 /* function getToken returns the 
- * next token in source file
+ * next token in the source file of cc;
+ * its lexeme is left as a span in
+ * cc->lexeme and cc->lexemeLength
+ */
+TokenType getToken(Compiler cc);
+
+/* function scanAll scans the whole source of cc
+ * up to its ENDFILE into an array of *n tokens,
+ * with the names interned in cc, and returns it;
+ * the lexemes are at their offsets in *text, which
+ * lasts as long as the scanner of cc. It returns
+ * NULL, scanning nothing, if the source is not
+ * mapped
+ */
+TokenRec * scanAll(Compiler cc, int * n, const char ** text);
+
+/* function replayTokens makes getToken hand out
+ * the n tokens at tokens, with their lexemes in
+ * text, and then ENDFILE, as the tokens of cc
+ */
+void replayTokens(Compiler cc, const TokenRec * tokens, int n,
+                  const char * text);
+
+/* function scanFree releases the
+ * scanner state of cc
  */
-TokenType getToken(void);
+void scanFree(Compiler cc);
 
 #endif
@@ -0,0 +1,202 @@
+/****************************************************/
+/* File: span.c                                     */
+/* Bulk skipping of runs of chars for the scanner,  */
+/* 16 or 32 bytes at a time where the CPU allows    */
+/****************************************************/
+
+#include "span.h"
+
+/* SPAN_X86 is set where SSE2 is always there and
+   AVX2 can be asked of the CPU */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SPAN_X86 1
+#include <immintrin.h>
+#else
+#define SPAN_X86 0
+#endif
+
+#define INLINE static inline __attribute__((always_inline))
+
+/* inRun is TRUE if c continues a run of kind */
+INLINE int inRun( int c, RunKind kind )
+{ switch (kind)
+  { case RunBlanks: return (c == ' ') || (c == '\t') || (c == '\n');
+    case RunComment: return c != '*';
+    case RunLetters: return (unsigned) ((c | 0x20) - 'a') < 26;
+    case RunDigits: return (unsigned) (c - '0') < 10;
+    default: return 1;
+  }
+}
+
+/* spanScalar is spanRun one char at a time */
+INLINE const char * spanScalar( const char * p, const char * end,
+                                RunKind kind, int * nl )
+{ int n = 0;
+  for (; (p < end) && inRun(*p,kind); p++) n += (*p == '\n');
+  if ((kind == RunBlanks) || (kind == RunComment) || (kind == RunAny))
+    *nl += n;
+  return p;
+}
+
+#if SPAN_X86
+
+/* chunk16 returns the mask of the 16 chars at p
+   that continue a run of kind, and sets *lf to the
+   mask of the newlines among them */
+INLINE unsigned chunk16( const char * p, RunKind kind, unsigned * lf )
+{ __m128i v = _mm_loadu_si128((const __m128i *) p);
+  __m128i nlv = _mm_cmpeq_epi8(v,_mm_set1_epi8('\n'));
+  __m128i in;
+  switch (kind)
+  { case RunBlanks:
+      in = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v,_mm_set1_epi8(' ')),
+                                     _mm_cmpeq_epi8(v,_mm_set1_epi8('\t'))),nlv);
+      break;
+    case RunComment:
+      in = _mm_xor_si128(_mm_cmpeq_epi8(v,_mm_set1_epi8('*')),
+                         _mm_set1_epi8(-1));
+      break;
+    case RunLetters: /* 'a'..'z' move to -128..-103 */
+      v = _mm_add_epi8(_mm_or_si128(v,_mm_set1_epi8(0x20)),
+                       _mm_set1_epi8((char) (128 - 'a')));
+      in = _mm_cmpgt_epi8(_mm_set1_epi8(-128 + 26),v);
+      break;
+    case RunDigits: /* '0'..'9' move to -128..-119 */
+      v = _mm_add_epi8(v,_mm_set1_epi8((char) (128 - '0')));
+      in = _mm_cmpgt_epi8(_mm_set1_epi8(-128 + 10),v);
+      break;
+    default:
+      in = _mm_set1_epi8(-1);
+      break;
+  }
+  *lf = (unsigned) _mm_movemask_epi8(nlv);
+  return (unsigned) _mm_movemask_epi8(in);
+}
+
+/* span16 is spanRun 16 chars at a time */
+INLINE const char * span16( const char * p, const char * end,
+                            RunKind kind, int * nl )
+{ unsigned in, lf;
+  int n = 0, k;
+  for (; end - p >= 16; p += 16)
+  { in = chunk16(p,kind,&lf);
+    if (in != 0xFFFF)
+    { k = __builtin_ctz(~in);
+      *nl += n + __builtin_popcount(lf & ((1u << k) - 1));
+      return p + k;
+    }
+    n += __builtin_popcount(lf);
+  }
+  *nl += n;
+  return spanScalar(p,end,kind,nl);
+}
+
+#define AVX2 __attribute__((target("avx2,popcnt")))
+
+/* chunk32 is chunk16 for 32 chars */
+INLINE AVX2 unsigned chunk32( const char * p, RunKind kind, unsigned * lf )
+{ __m256i v = _mm256_loadu_si256((const __m256i *) p);
+  __m256i nlv = _mm256_cmpeq_epi8(v,_mm256_set1_epi8('\n'));
+  __m256i in;
+  switch (kind)
+  { case RunBlanks:
+      in = _mm256_or_si256(
+             _mm256_or_si256(_mm256_cmpeq_epi8(v,_mm256_set1_epi8(' ')),
+                             _mm256_cmpeq_epi8(v,_mm256_set1_epi8('\t'))),nlv);
+      break;
+    case RunComment:
+      in = _mm256_xor_si256(_mm256_cmpeq_epi8(v,_mm256_set1_epi8('*')),
+                            _mm256_set1_epi8(-1));
+      break;
+    case RunLetters:
+      v = _mm256_add_epi8(_mm256_or_si256(v,_mm256_set1_epi8(0x20)),
+                          _mm256_set1_epi8((char) (128 - 'a')));
+      in = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26),v);
+      break;
+    case RunDigits:
+      v = _mm256_add_epi8(v,_mm256_set1_epi8((char) (128 - '0')));
+      in = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 10),v);
+      break;
+    default:
+      in = _mm256_set1_epi8(-1);
+      break;
+  }
+  *lf = (unsigned) _mm256_movemask_epi8(nlv);
+  return (unsigned) _mm256_movemask_epi8(in);
+}
+
+/* span32 is spanRun 32 chars at a time */
+INLINE AVX2 const char * span32( const char * p, const char * end,
+                                 RunKind kind, int * nl )
+{ unsigned in, lf;
+  int n = 0, k;
+  for (; end - p >= 32; p += 32)
+  { in = chunk32(p,kind,&lf);
+    if (in != 0xFFFFFFFF)
+    { k = __builtin_ctz(~in);
+      *nl += n + __builtin_popcount(lf & ((1u << k) - 1));
+      return p + k;
+    }
+    n += __builtin_popcount(lf);
+  }
+  *nl += n;
+  return span16(p,end,kind,nl);
+}
+
+/* the entry points of each level, with the kind
+   folded into the loops */
+static const char * sse2Blanks( const char * p, const char * end, int * nl )
+{ return span16(p,end,RunBlanks,nl); }
+static const char * sse2Comment( const char * p, const char * end, int * nl )
+{ return span16(p,end,RunComment,nl); }
+static const char * sse2Letters( const char * p, const char * end, int * nl )
+{ return span16(p,end,RunLetters,nl); }
+static const char * sse2Digits( const char * p, const char * end, int * nl )
+{ return span16(p,end,RunDigits,nl); }
+static const char * sse2Any( const char * p, const char * end, int * nl )
+{ return span16(p,end,RunAny,nl); }
+
+static AVX2 const char * avx2Blanks( const char * p, const char * end, int * nl )
+{ return span32(p,end,RunBlanks,nl); }
+static AVX2 const char * avx2Comment( const char * p, const char * end, int * nl )
+{ return span32(p,end,RunComment,nl); }
+static AVX2 const char * avx2Letters( const char * p, const char * end, int * nl )
+{ return span32(p,end,RunLetters,nl); }
+static AVX2 const char * avx2Digits( const char * p, const char * end, int * nl )
+{ return span32(p,end,RunDigits,nl); }
+static AVX2 const char * avx2Any( const char * p, const char * end, int * nl )
+{ return span32(p,end,RunAny,nl); }
+
+typedef const char * (* SpanFn)( const char * p, const char * end, int * nl );
+
+static const SpanFn spanFns[SpanAVX2+1][RunAny+1] =
+  { { NULL },
+    { sse2Blanks, sse2Comment, sse2Letters, sse2Digits, sse2Any },
+    { avx2Blanks, avx2Comment, avx2Letters, avx2Digits, avx2Any } };
+
+/* bestLevel runs before main to find the level of
+   the CPU */
+static void __attribute__((constructor)) bestLevel( void )
+{ __builtin_cpu_init();
+  spanLevel = __builtin_cpu_supports("avx2") ? SpanAVX2 : SpanSSE2;
+}
+
+#endif
+
+SpanLevel spanLevel = SpanScalar;
+
+const char * spanRun( const char * p, const char * end, RunKind kind,
+                      int * nl )
+{ /* a run of a char or two is best done at once */
+  if ((p < end) && !inRun(*p,kind)) return p;
+#if SPAN_X86
+  if (spanLevel != SpanScalar) return spanFns[spanLevel][kind](p,end,nl);
+#endif
+  switch (kind)
+  { case RunBlanks: return spanScalar(p,end,RunBlanks,nl);
+    case RunComment: return spanScalar(p,end,RunComment,nl);
+    case RunLetters: return spanScalar(p,end,RunLetters,nl);
+    case RunDigits: return spanScalar(p,end,RunDigits,nl);
+    default: return spanScalar(p,end,RunAny,nl);
+  }
+}
@@ -0,0 +1,33 @@
+/****************************************************/
+/* File: span.h                                     */
+/* Bulk skipping of runs of chars for the scanner,  */
+/* 16 or 32 bytes at a time where the CPU allows    */
+/****************************************************/
+
+#ifndef _SPAN_H_
+#define _SPAN_H_
+
+/* the runs spanRun skips: blanks, the text of a
+   comment up to its next '*', letters, digits,
+   and any text, to count its newlines */
+typedef enum { RunBlanks, RunComment, RunLetters, RunDigits, RunAny }
+  RunKind;
+
+/* the instruction sets spanRun may use */
+typedef enum { SpanScalar, SpanSSE2, SpanAVX2 } SpanLevel;
+
+/* spanLevel is the best level the CPU supports,
+ * found at startup; lowering it selects a slower
+ * path, as the benchmarks do
+ */
+extern SpanLevel spanLevel;
+
+/* Function spanRun returns the end of the run of
+ * the given kind that starts at p, or end if the
+ * run reaches it; for blanks, comments and any
+ * text, the newlines skipped are added to *nl
+ */
+const char * spanRun( const char * p, const char * end, RunKind kind,
+                      int * nl );
+
+#endif
@@ -1,9 +1,9 @@
 /****************************************************/
 /* File: symtab.c                                   */
 /* Symbol table implementation for the TINY compiler*/
-/* (allows only one symbol table)                   */
-/* Symbol table is implemented as a chained         */
-/* hash table                                       */
+/* (one symbol table per compilation)               */
+/* Each scope keeps its symbols in an array, with  */
+/* an open addressed hash index once it grows       */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -13,51 +13,154 @@
 #include <string.h>
 #include "symtab.h"
 #include "globals.h"
+#include "intern.h"
+#include "arena.h"
 
-/* SHIFT is the power of two used as multiplier
-   in hash function  */
-#define SHIFT 4
-#define MAX_SCOPES 1000
+/* the hash function; names are interned and
+   carry their hash */
+static int hash(char *key, int size)
+{
+  return (int)(((unsigned)internHash(key) * 2654435761u) & (unsigned)(size - 1));
+}
 
-/* the hash function */
-static int hash(char *key)
+/* the symbol table of a compilation: all scopes
+ * in creation order, and the stack of open scopes
+ * with the next free location of each; the arrays
+ * double when full
+ */
+typedef struct SymTabRec
 {
-  int temp = 0;
-  int i = 0;
-  while (key[i] != '\0')
+  ScopeList *scopes, *scopeStack;
+  int *location;
+  int cntScope, maxScope;
+  int cntScopeStack, maxScopeStack;
+} * SymTab;
+
+/* grow doubles the length *n of array p, whose
+ * elements have the given size, starting at 16,
+ * and returns the resized array
+ */
+static void *grow(Compiler cc, void *p, int *n, int size)
+{
+  *n = *n ? 2 * *n : 16;
+  p = realloc(p, (size_t)*n * size);
+  if (p == NULL)
   {
-    temp = ((temp << SHIFT) + key[i]) % SIZE;
-    ++i;
+    fprintf(cc->listing, "Out of memory error at line %d\n", cc->lineno);
+    exit(1);
   }
-  return temp;
+  return p;
 }
 
-ScopeList scopes[MAX_SCOPES], scopeStack[MAX_SCOPES];
-int cntScope = 0, cntScopeStack = 0, location[MAX_SCOPES];
+/* tableOf returns the symbol table of cc,
+ * creating it on first use
+ */
+static SymTab tableOf(Compiler cc)
+{
+  if (cc->symtab == NULL)
+  {
+    cc->symtab = (SymTab)calloc(1, sizeof(struct SymTabRec));
+    if (cc->symtab == NULL)
+    {
+      fprintf(cc->listing, "Out of memory error at line %d\n", cc->lineno);
+      exit(1);
+    }
+  }
+  return cc->symtab;
+}
+
+/* sc_find returns the symbol name of scope,
+ * NULL if the scope does not declare it; small
+ * scopes are searched in order, larger ones
+ * through their open addressed index
+ */
+static BucketList sc_find(ScopeList scope, char *name)
+{
+  int i;
+  if (scope->index == NULL)
+  {
+    for (i = 0; i < scope->symCount; i++)
+      if (scope->syms[i]->name == name)
+        return scope->syms[i];
+    return NULL;
+  }
+  for (i = hash(name, scope->indexSize); scope->index[i] != NULL;
+       i = (i + 1) & (scope->indexSize - 1))
+    if (scope->index[i]->name == name)
+      return scope->index[i];
+  return NULL;
+}
+
+/* sc_add appends symbol l to scope, growing
+ * the symbol array and the index as needed
+ */
+static void sc_add(Compiler cc, ScopeList scope, BucketList l)
+{
+  int i, j;
+  if (scope->symCount == scope->symMax)
+  {
+    BucketList *syms = (BucketList *)malloc(2 * scope->symMax * sizeof(BucketList));
+    if (syms == NULL)
+    {
+      fprintf(cc->listing, "Out of memory error at line %d\n", cc->lineno);
+      exit(1);
+    }
+    memcpy(syms, scope->syms, scope->symCount * sizeof(BucketList));
+    if (scope->syms != scope->inlineSyms)
+      free(scope->syms);
+    scope->syms = syms;
+    scope->symMax *= 2;
+  }
+  l->order = scope->symCount;
+  scope->syms[scope->symCount++] = l;
+  if (scope->symCount <= SCOPE_INLINE)
+    return;
+  /* keep the index at most half full */
+  if (2 * scope->symCount > scope->indexSize)
+  {
+    free(scope->index);
+    scope->indexSize = scope->indexSize ? 2 * scope->indexSize : 4 * SCOPE_INLINE;
+    scope->index = (BucketList *)calloc(scope->indexSize, sizeof(BucketList));
+    if (scope->index == NULL)
+    {
+      fprintf(cc->listing, "Out of memory error at line %d\n", cc->lineno);
+      exit(1);
+    }
+    for (j = 0; j < scope->symCount - 1; j++)
+    {
+      for (i = hash(scope->syms[j]->name, scope->indexSize); scope->index[i] != NULL;
+           i = (i + 1) & (scope->indexSize - 1))
+        ;
+      scope->index[i] = scope->syms[j];
+    }
+  }
+  for (i = hash(l->name, scope->indexSize); scope->index[i] != NULL;
+       i = (i + 1) & (scope->indexSize - 1))
+    ;
+  scope->index[i] = l;
+}
 
 /* Procedure st_insert inserts line numbers and
  * memory locations into the symbol table
  * loc = memory location is inserted only the
  * first time, otherwise ignored
  */
-void st_insert(char *name, int lineno, int loc, TreeNode *treeNode)
+void st_insert(Compiler cc, char *name, int lineno, int loc, TreeNode *treeNode)
 {
-  int h = hash(name);
-  ScopeList nowScope = sc_top();
-  BucketList l = nowScope->hashTable[h];
-  while ((l != NULL) && (strcmp(name, l->name) != 0))
-    l = l->next;
+  ScopeList nowScope = sc_top(cc);
+  BucketList l = sc_find(nowScope, name);
   if (l == NULL) /* variable not yet in table */
   {
-    l = (BucketList)malloc(sizeof(struct BucketListRec));
+    l = (BucketList)arenaAlloc(cc, sizeof(struct BucketListRec), ArenaOther);
     l->name = name;
     l->treeNode = treeNode;
-    l->lines = (LineList)malloc(sizeof(struct LineListRec));
+    l->lines = (LineList)arenaAlloc(cc, sizeof(struct LineListRec), ArenaOther);
     l->lines->lineno = lineno;
     l->memloc = loc;
     l->lines->next = NULL;
-    l->next = nowScope->hashTable[h];
-    nowScope->hashTable[h] = l;
+    l->lastLine = l->lines;
+    l->funcScope = NULL;
+    sc_add(cc, nowScope, l);
   }
   else /* found in table, so just add line number */
   {
@@ -72,91 +175,212 @@ void st_insert(char *name, int lineno, int loc, TreeNode *treeNode)
 /* Function st_lookup returns the memory 
  * location of a variable or -1 if not found
  */
-int st_lookup(char *name)
+int st_lookup(Compiler cc, char *name)
 {
-  BucketList l = get_bucket(name);
+  BucketList l = get_bucket(cc, name);
   if (l != NULL)
     return l->memloc;
   return -1;
 }
 
-void st_add_lineno(char *name, int lineno)
+void st_add_lineno(Compiler cc, char *name, int lineno)
+{
+  st_add_line(cc, get_bucket(cc, name), lineno);
+}
+
+void st_add_line(Compiler cc, BucketList l, int lineno)
 {
-  BucketList bl = get_bucket(name);
-  LineList ll = bl->lines;
-  while (ll->next != NULL)
-    ll = ll->next;
-  ll->next = (LineList)malloc(sizeof(struct LineListRec));
-  ll->next->lineno = lineno;
-  ll->next->next = NULL;
+  LineList ll = (LineList)arenaAlloc(cc, sizeof(struct LineListRec), ArenaOther);
+  ll->lineno = lineno;
+  ll->next = NULL;
+  l->lastLine->next = ll;
+  l->lastLine = ll;
 }
 
-int st_lookup_top(char *name)
+int st_lookup_top(Compiler cc, char *name)
 {
-  int h = hash(name);
-  ScopeList nowScope = sc_top();
-  //while(nowScope != NULL)
-  BucketList l = nowScope->hashTable[h];
-  while ((l != NULL) && (strcmp(name, l->name) != 0))
-    l = l->next;
+  BucketList l = sc_find(sc_top(cc), name);
   if (l != NULL)
     return l->memloc;
-  //  nowScope = nowScope->parent;
-
   return -1;
 }
 
-BucketList get_bucket(char *name)
+BucketList get_bucket(Compiler cc, char *name)
+{
+  ScopeList nowScope = sc_top(cc);
+  while (nowScope != NULL)
+  {
+    BucketList l = sc_find(nowScope, name);
+    if (l != NULL)
+      return l;
+    nowScope = nowScope->parent;
+  }
+  return NULL;
+}
+
+ScopeList get_bucket_scope(Compiler cc, char *name)
+{
+  ScopeList nowScope = sc_top(cc);
+  while (nowScope != NULL)
+  {
+    if (sc_find(nowScope, name) != NULL)
+      return nowScope;
+    nowScope = nowScope->parent;
+  }
+  return NULL;
+}
+
+BucketList get_bucket_at(Compiler cc, char *name, ScopeList *scope)
 {
-  int h = hash(name);
-  ScopeList nowScope = sc_top();
+  ScopeList nowScope = sc_top(cc);
   while (nowScope != NULL)
   {
-    BucketList l = nowScope->hashTable[h];
-    while ((l != NULL) && (strcmp(name, l->name) != 0))
-      l = l->next;
+    BucketList l = sc_find(nowScope, name);
     if (l != NULL)
+    {
+      *scope = nowScope;
       return l;
+    }
     nowScope = nowScope->parent;
   }
+  *scope = NULL;
   return NULL;
 }
 
 /* Stack for static scope */
-ScopeList sc_create(char *funcName)
+ScopeList sc_create(Compiler cc, char *funcName)
 {
+  SymTab st = tableOf(cc);
   ScopeList newScope;
-  newScope = (ScopeList)malloc(sizeof(struct ScopeListRec));
+  newScope = (ScopeList)arenaAlloc(cc, sizeof(struct ScopeListRec), ArenaOther);
   newScope->funcName = funcName;
-  newScope->nestedLevel = cntScopeStack;
-  newScope->parent = sc_top();
-  scopes[cntScope++] = newScope;
+  newScope->syms = newScope->inlineSyms;
+  newScope->symCount = 0;
+  newScope->symMax = SCOPE_INLINE;
+  newScope->index = NULL;
+  newScope->indexSize = 0;
+  newScope->nestedLevel = st->cntScopeStack;
+  newScope->frameSize = 0;
+  newScope->parent = sc_top(cc);
+  if (st->cntScope == st->maxScope)
+    st->scopes = (ScopeList *)grow(cc, st->scopes, &st->maxScope, sizeof(ScopeList));
+  st->scopes[st->cntScope++] = newScope;
+
+  /* the first scope a global function opens
+     holds its parameters */
+  if (newScope->parent != NULL && newScope->parent->nestedLevel == 0)
+  {
+    BucketList l = sc_find(newScope->parent, funcName);
+    if (l != NULL && l->funcScope == NULL &&
+        l->treeNode->nodekind == DeclK && l->treeNode->kind.decl == FuncK)
+      l->funcScope = newScope;
+  }
 
   return newScope;
 }
 
-ScopeList sc_top(void)
+ScopeList sc_top(Compiler cc)
 {
-  if (!cntScopeStack)
+  SymTab st = tableOf(cc);
+  if (!st->cntScopeStack)
     return NULL;
-  return scopeStack[cntScopeStack - 1];
+  return st->scopeStack[st->cntScopeStack - 1];
 }
 
-void sc_pop(void)
+void sc_pop(Compiler cc)
 {
-  if (cntScopeStack)
-    cntScopeStack--;
+  SymTab st = tableOf(cc);
+  if (st->cntScopeStack)
+    st->cntScopeStack--;
 }
 
-void sc_push(ScopeList scope)
+void sc_push(Compiler cc, ScopeList scope)
 {
-  scopeStack[cntScopeStack] = scope;
-  location[cntScopeStack++] = 0;
+  SymTab st = tableOf(cc);
+  if (st->cntScopeStack == st->maxScopeStack)
+  {
+    int n = st->maxScopeStack;
+    st->scopeStack = (ScopeList *)grow(cc, st->scopeStack, &st->maxScopeStack, sizeof(ScopeList));
+    st->location = (int *)grow(cc, st->location, &n, sizeof(int));
+  }
+  st->scopeStack[st->cntScopeStack] = scope;
+  /* a block inside a function keeps the locals
+     of the enclosing blocks alive */
+  if (scope->nestedLevel > 1 && st->cntScopeStack > 0)
+    st->location[st->cntScopeStack] = st->location[st->cntScopeStack - 1];
+  else
+    st->location[st->cntScopeStack] = 0;
+  st->cntScopeStack++;
 }
 
-int addLocation(void)
+int addLocation(Compiler cc, int size)
 {
-  return location[cntScopeStack - 1]++;
+  SymTab st = tableOf(cc);
+  int loc = st->location[st->cntScopeStack - 1];
+  /* the function scope sits just above the globals */
+  ScopeList frame = st->scopeStack[st->cntScopeStack > 1 ? 1 : 0];
+  st->location[st->cntScopeStack - 1] += size;
+  if (frame->frameSize < loc + size)
+    frame->frameSize = loc + size;
+  return loc;
+}
+
+int st_scope_count(Compiler cc)
+{
+  return tableOf(cc)->cntScope;
+}
+
+ScopeList *st_take_scopes(Compiler cc, int *n)
+{
+  SymTab st = tableOf(cc);
+  ScopeList *scopes = NULL;
+  *n = st->cntScope;
+  if (*n > 0)
+  {
+    scopes = (ScopeList *)malloc(*n * sizeof(ScopeList));
+    if (scopes == NULL)
+    {
+      fprintf(cc->listing, "Out of memory error at line %d\n", cc->lineno);
+      exit(1);
+    }
+    memcpy(scopes, st->scopes, *n * sizeof(ScopeList));
+  }
+  st->cntScope = 0;
+  return scopes;
+}
+
+void st_give_scopes(Compiler cc, ScopeList *scopes, int n)
+{
+  SymTab st = tableOf(cc);
+  int i;
+  for (i = 0; i < n; i++)
+  {
+    if (st->cntScope == st->maxScope)
+      st->scopes = (ScopeList *)grow(cc, st->scopes, &st->maxScope, sizeof(ScopeList));
+    st->scopes[st->cntScope++] = scopes[i];
+  }
+}
+
+/* Procedure st_free releases the symbol table of
+ * cc; the scopes and symbols live in its arena
+ */
+void st_free(Compiler cc)
+{
+  SymTab st = cc->symtab;
+  int i;
+  if (st == NULL)
+    return;
+  for (i = 0; i < st->cntScope; i++)
+  {
+    if (st->scopes[i]->syms != st->scopes[i]->inlineSyms)
+      free(st->scopes[i]->syms);
+    free(st->scopes[i]->index);
+  }
+  free(st->scopes);
+  free(st->scopeStack);
+  free(st->location);
+  free(st);
+  cc->symtab = NULL;
 }
 
 /* Procedure printSymTab prints a formatted 
@@ -164,369 +388,328 @@ int addLocation(void)
  * to the listing file
  */
 
-void printSymTab(FILE *listing)
+void printSymTab(Compiler cc, FILE *listing)
 {
-  print_SymTab(listing);
+  print_SymTab(cc, listing);
   fprintf(listing, "\n");
-  print_FuncTab(listing);
+  print_FuncTab(cc, listing);
   fprintf(listing, "\n");
-  print_Func_globVar(listing);
+  print_Func_globVar(cc, listing);
   fprintf(listing, "\n");
-  print_FuncP_N_LoclVar(listing);
+  print_FuncP_N_LoclVar(cc, listing);
 } /* printSymTab */
 
-void print_SymTab(FILE *listing)
+void print_SymTab(Compiler cc, FILE *listing)
 {
+  SymTab st = tableOf(cc);
   int i, j;
   fprintf(listing, "\n< Symbol Table >\n");
   fprintf(listing, "Variable Name  Variable Type  Scope Name  Location  Line Numbers\n");
   fprintf(listing, "-------------  -------------  ----------  --------  ------------\n");
 
-  for (i = 0; i < cntScope; i++)
+  for (i = 0; i < st->cntScope; i++)
   {
-    ScopeList nowScope = scopes[i];
-    BucketList *hashTable = nowScope->hashTable;
+    ScopeList nowScope = st->scopes[i];
 
-    for (j = 0; j < SIZE; j++)
+    for (j = 0; j < nowScope->symCount; j++)
     {
-      if (hashTable[j] != NULL)
-      {
-        BucketList bl = hashTable[j];
-        TreeNode *node = bl->treeNode;
+      BucketList bl = nowScope->syms[j];
+      TreeNode *node = bl->treeNode;
 
-        while (bl != NULL)
-        {
-          LineList ll = bl->lines;
-          fprintf(listing, "%-15s", bl->name);
+      LineList ll = bl->lines;
+      fprintf(listing, "%-15s", bl->name);
 
-          switch (node->nodekind)
+      switch (node->nodekind)
+      {
+      case DeclK:
+        switch (node->kind.decl)
+        {
+        case FuncK:
+          fprintf(listing, "%-15s", "Function");
+          break;
+        case VarK:
+          switch (node->type)
           {
-          case DeclK:
-            switch (node->kind.decl)
-            {
-            case FuncK:
-              fprintf(listing, "%-15s", "Function");
-              break;
-            case VarK:
-              switch (node->type)
-              {
-              case Void:
-                fprintf(listing, "%-15s", "Void");
-                break;
-              case Integer:
-                fprintf(listing, "%-15s", "Integer");
-                break;
-              default:
-                break;
-              }
-              break;
-            case ArrVarK:
-              fprintf(listing, "%-15s", "IntegerArray");
-              break;
-            default:
-              break;
-            }
+          case Void:
+            fprintf(listing, "%-15s", "Void");
             break;
-          case ParamK:
-            switch (node->kind.param)
-            {
-            case ArrParamK:
-              fprintf(listing, "%-15s", "IntegerArray");
-              break;
-            case NonArrParamK:
-              fprintf(listing, "%-15s", "Integer");
-              break;
-            default:
-              break;
-            }
+          case Integer:
+            fprintf(listing, "%-15s", "Integer");
             break;
           default:
             break;
           }
-
-          fprintf(listing, "%-12s", nowScope->funcName);
-          fprintf(listing, "%-10d", bl->memloc);
-          while (ll != NULL)
-          {
-            fprintf(listing, "%4d", ll->lineno);
-            ll = ll->next;
-          }
-          fprintf(listing, "\n");
-
-          bl = bl->next;
+          break;
+        case ArrVarK:
+          fprintf(listing, "%-15s", "IntegerArray");
+          break;
+        default:
+          break;
         }
+        break;
+      case ParamK:
+        switch (node->kind.param)
+        {
+        case ArrParamK:
+          fprintf(listing, "%-15s", "IntegerArray");
+          break;
+        case NonArrParamK:
+          fprintf(listing, "%-15s", "Integer");
+          break;
+        default:
+          break;
+        }
+        break;
+      default:
+        break;
       }
+
+      fprintf(listing, "%-12s", nowScope->funcName);
+      fprintf(listing, "%-10d", bl->memloc);
+      while (ll != NULL)
+      {
+        fprintf(listing, "%4d", ll->lineno);
+        ll = ll->next;
+      }
+      fprintf(listing, "\n");
+
     }
   }
 }
 
-void print_FuncTab(FILE *listing)
+void print_FuncTab(Compiler cc, FILE *listing)
 {
-  int i, j, k, l;
+  SymTab st = tableOf(cc);
+  int i, j, l;
   fprintf(listing, "\n< Function Table >\n");
   fprintf(listing, "Function Name  Scope Name  Return Type  Parameter Name  Parameter Type\n");
   fprintf(listing, "-------------  ----------  -----------  --------------  --------------\n");
 
-  for (i = 0; i < cntScope; i++)
+  for (i = 0; i < st->cntScope; i++)
   {
-    ScopeList nowScope = scopes[i];
-    BucketList *hashTable = nowScope->hashTable;
+    ScopeList nowScope = st->scopes[i];
 
-    for (j = 0; j < SIZE; j++)
+    for (j = 0; j < nowScope->symCount; j++)
     {
-      if (hashTable[j] != NULL)
-      {
-        BucketList bl = hashTable[j];
-        TreeNode *node = bl->treeNode;
+      BucketList bl = nowScope->syms[j];
+      TreeNode *node = bl->treeNode;
 
-        while (bl != NULL)
+      switch (node->nodekind)
+      {
+      case DeclK:
+        if (node->kind.decl == FuncK) /* Function print */
         {
-          switch (node->nodekind)
+          fprintf(listing, "%-15s", bl->name);
+          fprintf(listing, "%-12s", nowScope->funcName);
+          switch (node->type)
           {
-          case DeclK:
-            if (node->kind.decl == FuncK) /* Function print */
+          case Void:
+            fprintf(listing, "%-13s", "Void");
+            break;
+          case Integer:
+            fprintf(listing, "%-13s", "Integer");
+            break;
+          default:
+            break;
+          }
+
+          int noParam = TRUE;
+          ScopeList paramScope = bl->funcScope;
+          if (paramScope != NULL)
+          {
+            for (l = 0; l < paramScope->symCount; l++)
             {
-              fprintf(listing, "%-15s", bl->name);
-              fprintf(listing, "%-12s", nowScope->funcName);
-              switch (node->type)
-              {
-              case Void:
-                fprintf(listing, "%-13s", "Void");
-                break;
-              case Integer:
-                fprintf(listing, "%-13s", "Integer");
-                break;
-              default:
-                break;
-              }
+              BucketList pbl = paramScope->syms[l];
+              TreeNode *pnode = pbl->treeNode;
 
-              int noParam = TRUE;
-              for (k = 0; k < cntScope; k++)
+              switch (pnode->nodekind)
               {
-                ScopeList paramScope = scopes[k];
-                if (strcmp(paramScope->funcName, bl->name) != 0)
-                  continue;
-                BucketList *paramhashTable = paramScope->hashTable; //printf("c\n");
-
-                for (l = 0; l < SIZE; l++)
+              case ParamK:
+                noParam = FALSE;
+                fprintf(listing, "\n");
+                fprintf(listing, "%-40s", "");
+                fprintf(listing, "%-16s", pbl->name);
+                switch (pnode->type)
                 {
-                  if (paramhashTable[l] != NULL)
-                  {
-                    BucketList pbl = paramhashTable[l];
-                    TreeNode *pnode = pbl->treeNode;
-
-                    while (pbl != NULL)
-                    {
-                      switch (pnode->nodekind)
-                      {
-                      case ParamK:
-                        noParam = FALSE;
-                        fprintf(listing, "\n");
-                        fprintf(listing, "%-40s", "");
-                        fprintf(listing, "%-16s", pbl->name);
-                        switch (pnode->type)
-                        {
-                        case Integer:
-                          fprintf(listing, "%-14s", "Integer");
-                          break;
-                        case IntegerArray:
-                          fprintf(listing, "%-14s", "IntegerArray");
-                          break;
-                        default:
-                          break;
-                        }
-                        break;
-                      default:
-                        break;
-                      }
-                      pbl = pbl->next;
-                    }
-                  }
+                case Integer:
+                  fprintf(listing, "%-14s", "Integer");
+                  break;
+                case IntegerArray:
+                  fprintf(listing, "%-14s", "IntegerArray");
+                  break;
+                default:
+                  break;
                 }
                 break;
+              default:
+                break;
               }
-              if (noParam)
-              {
-                fprintf(listing, "%-16s", "");
-                if (strcmp(bl->name, "output") != 0)
-                  fprintf(listing, "%-14s", "Void");
-                else
-                  fprintf(listing, "\n%-56s%-14s", "", "Integer");
-              }
-
-              fprintf(listing, "\n");
             }
-            break;
-          default:
-            break;
           }
-          bl = bl->next;
+          if (noParam)
+          {
+            fprintf(listing, "%-16s", "");
+            if (strcmp(bl->name, "output") != 0)
+              fprintf(listing, "%-14s", "Void");
+            else
+              fprintf(listing, "\n%-56s%-14s", "", "Integer");
+          }
+
+          fprintf(listing, "\n");
         }
+        break;
+      default:
+        break;
       }
     }
   }
 }
 
-void print_Func_globVar(FILE *listing)
+void print_Func_globVar(Compiler cc, FILE *listing)
 {
+  SymTab st = tableOf(cc);
   int i, j;
   fprintf(listing, "\n< Function and Global Variables >\n");
   fprintf(listing, "   ID Name      ID Type    Data Type\n");
   fprintf(listing, "-------------  ---------  -----------\n");
 
-  for (i = 0; i < cntScope; i++)
+  for (i = 0; i < st->cntScope; i++)
   {
-    ScopeList nowScope = scopes[i];
-    if (strcmp(nowScope->funcName, "global") != 0)
+    ScopeList nowScope = st->scopes[i];
+    if (nowScope->nestedLevel != 0)
       continue;
 
-    BucketList *hashTable = nowScope->hashTable;
-
-    for (j = 0; j < SIZE; j++)
+    for (j = 0; j < nowScope->symCount; j++)
     {
-      if (hashTable[j] != NULL)
-      {
-        BucketList bl = hashTable[j];
-        TreeNode *node = bl->treeNode;
+      BucketList bl = nowScope->syms[j];
+      TreeNode *node = bl->treeNode;
 
-        while (bl != NULL)
+      switch (node->nodekind)
+      {
+      case DeclK:
+        fprintf(listing, "%-15s", bl->name);
+        switch (node->kind.decl)
         {
-          switch (node->nodekind)
+        case FuncK:
+          fprintf(listing, "%-11s", "Function");
+          switch (node->type)
           {
-          case DeclK:
-            fprintf(listing, "%-15s", bl->name);
-            switch (node->kind.decl)
-            {
-            case FuncK:
-              fprintf(listing, "%-11s", "Function");
-              switch (node->type)
-              {
-              case Void:
-                fprintf(listing, "%-11s", "Void");
-                break;
-              case Integer:
-                fprintf(listing, "%-11s", "Integer");
-                break;
-              default:
-                break;
-              }
-              break;
-            case VarK:
-              switch (node->type)
-              {
-              case Void:
-                fprintf(listing, "%-11s", "Variable");
-                fprintf(listing, "%-11s", "Void");
-                break;
-              case Integer:
-                fprintf(listing, "%-11s", "Variable");
-                fprintf(listing, "%-11s", "Integer");
-                break;
-              default:
-                break;
-              }
-              break;
-            case ArrVarK:
-              fprintf(listing, "%-11s", "Variable");
-              fprintf(listing, "%-15s", "IntegerArray");
-              break;
-            default:
-              break;
-            }
-            fprintf(listing, "\n");
+          case Void:
+            fprintf(listing, "%-11s", "Void");
+            break;
+          case Integer:
+            fprintf(listing, "%-11s", "Integer");
             break;
           default:
             break;
           }
-          bl = bl->next;
+          break;
+        case VarK:
+          switch (node->type)
+          {
+          case Void:
+            fprintf(listing, "%-11s", "Variable");
+            fprintf(listing, "%-11s", "Void");
+            break;
+          case Integer:
+            fprintf(listing, "%-11s", "Variable");
+            fprintf(listing, "%-11s", "Integer");
+            break;
+          default:
+            break;
+          }
+          break;
+        case ArrVarK:
+          fprintf(listing, "%-11s", "Variable");
+          fprintf(listing, "%-15s", "IntegerArray");
+          break;
+        default:
+          break;
         }
+        fprintf(listing, "\n");
+        break;
+      default:
+        break;
       }
     }
     break;
   }
 }
 
-void print_FuncP_N_LoclVar(FILE *listing)
+void print_FuncP_N_LoclVar(Compiler cc, FILE *listing)
 {
+  SymTab st = tableOf(cc);
   int i, j;
   fprintf(listing, "\n< Function Parameters and Local Variables >\n");
   fprintf(listing, "  Scope Name    Nested Level     ID Name      Data Type \n");
   fprintf(listing, "--------------  ------------  -------------  -----------\n");
 
-  for (i = 0; i < cntScope; i++)
+  for (i = 0; i < st->cntScope; i++)
   {
-    ScopeList nowScope = scopes[i];
-    if (strcmp(nowScope->funcName, "global") == 0)
+    ScopeList nowScope = st->scopes[i];
+    if (nowScope->nestedLevel == 0)
       continue;
-    BucketList *hashTable = nowScope->hashTable;
     //fprintf(listing,"%s\n",nowScope->funcName);
 
     int noParamVar = TRUE;
-    for (j = 0; j < SIZE; j++)
+    for (j = 0; j < nowScope->symCount; j++)
     {
-      if (hashTable[j] != NULL)
-      {
-        BucketList bl = hashTable[j];
-        TreeNode *node = bl->treeNode;
+      BucketList bl = nowScope->syms[j];
+      TreeNode *node = bl->treeNode;
 
-        while (bl != NULL)
+      switch (node->nodekind)
+      {
+      case DeclK:
+        noParamVar = FALSE;
+        fprintf(listing, "%-16s", nowScope->funcName);
+        fprintf(listing, "%-14d", nowScope->nestedLevel);
+        switch (node->kind.decl)
         {
-          switch (node->nodekind)
+        case VarK:
+          switch (node->type)
           {
-          case DeclK:
-            noParamVar = FALSE;
-            fprintf(listing, "%-16s", nowScope->funcName);
-            fprintf(listing, "%-14d", nowScope->nestedLevel);
-            switch (node->kind.decl)
-            {
-            case VarK:
-              switch (node->type)
-              {
-              case Void:
-                fprintf(listing, "%-15s", node->attr.name);
-                fprintf(listing, "%-11s", "Void");
-                break;
-              case Integer:
-                fprintf(listing, "%-15s", node->attr.name);
-                fprintf(listing, "%-11s", "Integer");
-                break;
-              default:
-                break;
-              }
-              break;
-            case ArrVarK:
-              fprintf(listing, "%-15s", node->attr.arr.name);
-              fprintf(listing, "%-11s", "IntegerArray");
-              break;
-            default:
-              break;
-            }
-            fprintf(listing, "\n");
+          case Void:
+            fprintf(listing, "%-15s", node->attr.name);
+            fprintf(listing, "%-11s", "Void");
             break;
-          case ParamK:
-            noParamVar = FALSE;
-            fprintf(listing, "%-16s", nowScope->funcName);
-            fprintf(listing, "%-14d", nowScope->nestedLevel);
-            switch (node->kind.param)
-            {
-            case ArrParamK:
-              fprintf(listing, "%-15s", node->attr.name);
-              fprintf(listing, "%-11s", "IntegerArray");
-              break;
-            case NonArrParamK:
-              fprintf(listing, "%-15s", node->attr.name);
-              fprintf(listing, "%-11s", "Integer");
-              break;
-            default:
-              break;
-            }
-            fprintf(listing, "\n");
+          case Integer:
+            fprintf(listing, "%-15s", node->attr.name);
+            fprintf(listing, "%-11s", "Integer");
             break;
           default:
             break;
           }
-          bl = bl->next;
+          break;
+        case ArrVarK:
+          fprintf(listing, "%-15s", node->attr.arr.name);
+          fprintf(listing, "%-11s", "IntegerArray");
+          break;
+        default:
+          break;
+        }
+        fprintf(listing, "\n");
+        break;
+      case ParamK:
+        noParamVar = FALSE;
+        fprintf(listing, "%-16s", nowScope->funcName);
+        fprintf(listing, "%-14d", nowScope->nestedLevel);
+        switch (node->kind.param)
+        {
+        case ArrParamK:
+          fprintf(listing, "%-15s", node->attr.name);
+          fprintf(listing, "%-11s", "IntegerArray");
+          break;
+        case NonArrParamK:
+          fprintf(listing, "%-15s", node->attr.name);
+          fprintf(listing, "%-11s", "Integer");
+          break;
+        default:
+          break;
         }
+        fprintf(listing, "\n");
+        break;
+      default:
+        break;
       }
     }
     if (!noParamVar)
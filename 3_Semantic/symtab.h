@@ -1,7 +1,7 @@
 /****************************************************/
 /* File: symtab.h                                   */
 /* Symbol table interface for the TINY compiler     */
-/* (allows only one symbol table)                   */
+/* (one symbol table per compilation)               */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -9,8 +9,10 @@
 #ifndef _SYMTAB_H_
 #define _SYMTAB_H_
 
-/* SIZE is the size of the hash table */
-#define SIZE 211
+/* SCOPE_INLINE is the number of symbols a scope
+ * holds before it builds a hash index
+ */
+#define SCOPE_INLINE 8
 
 #include "globals.h"
 
@@ -28,49 +30,110 @@ typedef struct BucketListRec
   char *name;
   TreeNode *treeNode;
   LineList lines;
+  LineList lastLine; /* tail of lines, for appending */
   int memloc;
-  struct BucketListRec *next;
+  struct ScopeListRec *funcScope; /* parameter scope of a function */
+  int order;                      /* position in its scope */
 } * BucketList;
 
 typedef struct ScopeListRec
 {
   char *funcName;
-  BucketList hashTable[SIZE];
+  BucketList *syms;  /* symbols in declaration order */
+  int symCount;
+  int symMax;
+  BucketList *index; /* open addressed by name hash, */
+  int indexSize;     /* NULL for a small scope       */
+  BucketList inlineSyms[SCOPE_INLINE];
   struct ScopeListRec *parent;
   int nestedLevel;
+  int frameSize; /* locations used by a function scope and */
+                 /* its nested scopes, or by the globals    */
 } * ScopeList;
 
+/* Names passed to the symbol table functions
+ * must be interned (intern.h); they are compared
+ * by pointer. Each function works on the symbol
+ * table of compilation cc
+ */
+
 /* Procedure st_insert inserts line numbers and
  * memory locations into the symbol table
  * loc = memory location is inserted only the
  * first time, otherwise ignored
  */
-void st_insert(char *name, int lineno, int loc, TreeNode *treeNode);
+void st_insert(Compiler cc, char *name, int lineno, int loc, TreeNode *treeNode);
 
 /* Function st_lookup returns the memory 
  * location of a variable or -1 if not found
  */
-int st_lookup(char *name);
-void st_add_lineno(char *name, int lineno);
-int st_lookup_top(char *name);
+int st_lookup(Compiler cc, char *name);
+void st_add_lineno(Compiler cc, char *name, int lineno);
+
+/* Procedure st_add_line adds lineno to the line
+ * numbers of symbol l
+ */
+void st_add_line(Compiler cc, BucketList l, int lineno);
+int st_lookup_top(Compiler cc, char *name);
 
-BucketList get_bucket(char *name);
+BucketList get_bucket(Compiler cc, char *name);
+
+/* Function get_bucket_scope returns the scope
+ * in which get_bucket finds name, NULL if none
+ */
+ScopeList get_bucket_scope(Compiler cc, char *name);
+
+/* Function get_bucket_at returns what get_bucket
+ * does, and sets *scope to what get_bucket_scope
+ * does, in a single search
+ */
+BucketList get_bucket_at(Compiler cc, char *name, ScopeList *scope);
 
 /* Stack for static scope */
-ScopeList sc_create(char *funcName);
-ScopeList sc_top(void);
-void sc_pop(void);
-void sc_push(ScopeList scope);
-int addLocation(void);
+ScopeList sc_create(Compiler cc, char *funcName);
+ScopeList sc_top(Compiler cc);
+void sc_pop(Compiler cc);
+void sc_push(Compiler cc, ScopeList scope);
+
+/* Function addLocation reserves size memory
+ * locations in the top scope and returns the
+ * first; nested scopes continue after the
+ * locations of their enclosing scope
+ */
+int addLocation(Compiler cc, int size);
+
+/* Function st_scope_count returns the number of
+ * scopes listed in the symbol table of cc
+ */
+int st_scope_count(Compiler cc);
+
+/* Function st_take_scopes returns the scopes
+ * listed in the symbol table of cc, in creation
+ * order, as an array of *n scopes that the caller
+ * frees; the table no longer lists or releases
+ * them
+ */
+ScopeList *st_take_scopes(Compiler cc, int *n);
+
+/* Procedure st_give_scopes appends the n scopes
+ * to those of the symbol table of cc, which then
+ * lists and releases them
+ */
+void st_give_scopes(Compiler cc, ScopeList *scopes, int n);
+
+/* Procedure st_free releases the symbol table
+ * of cc
+ */
+void st_free(Compiler cc);
 
 /* Procedure printSymTab prints a formatted 
  * listing of the symbol table contents 
  * to the listing file
  */
-void printSymTab(FILE *listing);
-void print_SymTab(FILE *listing);
-void print_FuncTab(FILE *listing);
-void print_Func_globVar(FILE *listing);
-void print_FuncP_N_LoclVar(FILE *listing);
+void printSymTab(Compiler cc, FILE *listing);
+void print_SymTab(Compiler cc, FILE *listing);
+void print_FuncTab(Compiler cc, FILE *listing);
+void print_Func_globVar(Compiler cc, FILE *listing);
+void print_FuncP_N_LoclVar(Compiler cc, FILE *listing);
 
 #endif
@@ -9,6 +9,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "tmo.h"
 
 #ifndef TRUE
 #define TRUE 1
@@ -18,10 +24,22 @@
 #endif
 
 /******* const *******/
-#define   IADDR_SIZE  1024 /* increase for large programs */
-#define   DADDR_SIZE  1024 /* increase for large programs */
+/* default memory sizes, see the -i and -d options */
+#define   IADDR_SIZE  1024 /* iMem grows past this while loading */
+#define   DADDR_SIZE  1024
 #define   NO_REGS 8
 #define   PC_REG  7
+#define   ZERO_REG NO_REGS /* always 0, used by decoded code only */
+
+/* set USE_COMPUTED_GOTO to FALSE to force the portable
+   switch dispatch in the decoded execution engine */
+#ifndef USE_COMPUTED_GOTO
+#ifdef __GNUC__
+#define   USE_COMPUTED_GOTO TRUE
+#else
+#define   USE_COMPUTED_GOTO FALSE
+#endif
+#endif
 
 #define   LINESIZE  121
 #define   WORDSIZE  20
@@ -70,12 +88,41 @@ typedef enum {
    srZERODIVIDE
    } STEPRESULT;
 
+/* same record as in binary object files */
+typedef TMOInst INSTRUCTION;
+
+/* opcodes of the pre-decoded instruction stream */
+typedef enum {
+   dHALT,     /* halt */
+   dSTEP,     /* not decoded: execute through stepTM */
+   dADD,      /* reg(r) = reg(s)+reg(t) */
+   dSUB,      /* reg(r) = reg(s)-reg(t) */
+   dMUL,      /* reg(r) = reg(s)*reg(t) */
+   dDIV,      /* reg(r) = reg(s)/reg(t) */
+   dLD,       /* reg(r) = mem(d+reg(s)) */
+   dLDPC,     /* pc = mem(d+reg(s)) */
+   dST,       /* mem(d+reg(s)) = reg(r) */
+   dLDA,      /* reg(r) = d+reg(s), also LDC */
+   dJMP,      /* pc = d+reg(s) */
+   dJLT,      /* if reg(r)<0 then pc = d+reg(s) */
+   dJLE,      /* if reg(r)<=0 then pc = d+reg(s) */
+   dJGT,      /* if reg(r)>0 then pc = d+reg(s) */
+   dJGE,      /* if reg(r)>=0 then pc = d+reg(s) */
+   dJEQ,      /* if reg(r)==0 then pc = d+reg(s) */
+   dJNE,      /* if reg(r)!=0 then pc = d+reg(s) */
+   dIMEM      /* sentinel past the end of iMem */
+   } DOPCODE;
+
+/* a pre-decoded instruction: pc-relative operands are
+   folded into d with s = ZERO_REG */
 typedef struct {
-      int iop  ;
-      int iarg1  ;
-      int iarg2  ;
-      int iarg3  ;
-   } INSTRUCTION;
+#if USE_COMPUTED_GOTO
+      const void * handler ;
+#endif
+      int dop ;
+      int r, s, t ;
+      int d ;
+   } DINSTRUCTION;
 
 /******** vars ********/
 int iloc = 0 ;
@@ -83,24 +130,31 @@ int dloc = 0 ;
 int traceflag = FALSE;
 int icountflag = FALSE;
 
-INSTRUCTION iMem [IADDR_SIZE];
-int dMem [DADDR_SIZE];
-int reg [NO_REGS];
+INSTRUCTION * iMem = NULL; /* allocated, or the mapped object file */
+int iMemSize = 0;          /* locations valid in iMem */
+int iMemMax = 0;           /* -i limit, 0 = grow as needed */
+int * dMem = NULL;
+int dMemSize = DADDR_SIZE;
+int reg [NO_REGS+1];
 
-char * opCodeTab[]
-        = {"HALT","IN","OUT","ADD","SUB","MUL","DIV","????",
-            /* RR opcodes */
-           "LD","ST","????", /* RM opcodes */
-           "LDA","LDC","JLT","JLE","JGT","JGE","JEQ","JNE","????"
-           /* RA opcodes */
-          };
+DINSTRUCTION * dCode = NULL; /* iMemSize+1 entries */
+int dCodeThreaded = FALSE;
+
+/* data-init and comment sections of a binary object */
+TMOData * dataInit = NULL;
+int dataCount = 0;
+TMOLine * lineTab = NULL;
+int lineCount = 0;
+char * lineStr = NULL;
+
+char * opCodeTab[] = TMO_OPCODES;
 
 char * stepResultTab[]
         = {"OK","Halted","Instruction Memory Fault",
            "Data Memory Fault","Division by 0"
           };
 
-char pgmName[20];
+char pgmName[120];
 FILE *pgm  ;
 
 char in_Line[LINESIZE] ;
@@ -120,8 +174,9 @@ int opClass( int c )
 
 /********************************************/
 void writeInstruction ( int loc )
-{ printf( "%5d: ", loc) ;
-  if ( (loc >= 0) && (loc < IADDR_SIZE) )
+{ int lo, hi, mid;
+  printf( "%5d: ", loc) ;
+  if ( (loc >= 0) && (loc < iMemSize) )
   { printf("%6s%3d,", opCodeTab[iMem[loc].iop], iMem[loc].iarg1);
     switch ( opClass(iMem[loc].iop) )
     { case opclRR: printf("%1d,%1d", iMem[loc].iarg2, iMem[loc].iarg3);
@@ -130,6 +185,16 @@ void writeInstruction ( int loc )
       case opclRA: printf("%3d(%1d)", iMem[loc].iarg2, iMem[loc].iarg3);
                    break;
     }
+    /* comments of a binary object, sorted by loc */
+    lo = 0 ;
+    hi = lineCount ;
+    while (lo < hi)
+    { mid = (lo + hi) / 2 ;
+      if (lineTab[mid].loc < loc) lo = mid + 1 ;
+      else hi = mid ;
+    }
+    for ( ; (lo < lineCount) && (lineTab[lo].loc == loc) ; lo++)
+      printf("\t%s", lineStr + lineTab[lo].str) ;
     printf ("\n") ;
   }
 } /* writeInstruction */
@@ -217,22 +282,49 @@ int error( char * msg, int lineNo, int instNo)
   return FALSE;
 } /* error */
 
+/********************************************/
+void resetTM (void)
+{ int regNo, loc;
+  for (regNo = 0;  regNo < NO_REGS ; regNo++)
+        reg[regNo] = 0 ;
+  dMem[0] = dMemSize - 1 ;
+  for (loc = 1 ; loc < dMemSize ; loc++)
+        dMem[loc] = 0 ;
+  for (loc = 0 ; loc < dataCount ; loc++)
+        dMem[dataInit[loc].addr] = dataInit[loc].value ;
+} /* resetTM */
+
+/********************************************/
+/* growIMem makes iMem large enough to hold
+   location loc; new locations hold HALT */
+int growIMem ( int loc )
+{ int size = iMemSize ;
+  INSTRUCTION * p ;
+  if ( loc < iMemSize ) return TRUE ;
+  if ( iMemMax > 0 )
+  { if ( loc >= iMemMax ) return FALSE ;
+    size = iMemMax ;
+  }
+  else
+  { if ( size == 0 ) size = IADDR_SIZE ;
+    while ( size <= loc ) size *= 2 ;
+  }
+  p = realloc(iMem, size * sizeof(INSTRUCTION)) ;
+  if ( p == NULL ) return FALSE ;
+  memset(p + iMemSize, 0, (size - iMemSize) * sizeof(INSTRUCTION)) ;
+  iMem = p ;
+  iMemSize = size ;
+  return TRUE ;
+} /* growIMem */
+
 /********************************************/
 int readInstructions (void)
 { OPCODE op;
   int arg1, arg2, arg3;
-  int loc, regNo, lineNo;
-  for (regNo = 0 ; regNo < NO_REGS ; regNo++)
-      reg[regNo] = 0 ;
-  dMem[0] = DADDR_SIZE - 1 ;
-  for (loc = 1 ; loc < DADDR_SIZE ; loc++)
-      dMem[loc] = 0 ;
-  for (loc = 0 ; loc < IADDR_SIZE ; loc++)
-  { iMem[loc].iop = opHALT ;
-    iMem[loc].iarg1 = 0 ;
-    iMem[loc].iarg2 = 0 ;
-    iMem[loc].iarg3 = 0 ;
-  }
+  int loc, lineNo;
+  resetTM ();
+  if ( ! growIMem (0))
+    return error("Out of instruction memory", 0, -1);
   lineNo = 0 ;
   while (! feof(pgm))
   { fgets( in_Line, LINESIZE-2, pgm  ) ;
@@ -245,7 +337,7 @@ int readInstructions (void)
     { if (! getNum())
         return error("Bad location", lineNo,-1);
       loc = num;
-      if (loc > IADDR_SIZE)
+      if ( (loc < 0) || (! growIMem (loc)) )
         return error("Location too large",lineNo,loc);
       if (! skipCh(':'))
         return error("Missing colon", lineNo,loc);
@@ -302,6 +394,70 @@ int readInstructions (void)
   return TRUE;
 } /* readInstructions */
 
+/********************************************/
+/* loadObject maps a binary object file (see
+   tmo.h) and uses its code in place */
+int loadObject (char * name)
+{ int fd, loc;
+  struct stat st;
+  char * base;
+  TMOHeader * h;
+  size_t size;
+  fd = open(name, O_RDONLY);
+  if ( (fd < 0) || (fstat(fd, &st) < 0) )
+    return error("Cannot open object file", 0, -1);
+  if ( st.st_size < (off_t) sizeof(TMOHeader) )
+  { close(fd);
+    return error("Object file too short", 0, -1);
+  }
+  base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if ( base == MAP_FAILED )
+    return error("Cannot map object file", 0, -1);
+  h = (TMOHeader *) base;
+  if ( (memcmp(h->magic, TMO_MAGIC, 4) != 0)
+       || (h->version != TMO_VERSION) || (h->byteOrder != 1)
+       || (h->instSize != sizeof(INSTRUCTION)) )
+    return error("Bad object file header", 0, -1);
+  if ( (h->instCount < 0) || ((iMemMax > 0) && (h->instCount > iMemMax))
+       || (h->dataCount < 0) || (h->lineCount < 0) || (h->strSize < 0) )
+    return error("Bad object file section size", 0, -1);
+  size = sizeof(TMOHeader)
+         + (size_t) h->instCount * sizeof(INSTRUCTION)
+         + (size_t) h->dataCount * sizeof(TMOData)
+         + (size_t) h->lineCount * sizeof(TMOLine)
+         + (size_t) h->strSize;
+  if ( size > (size_t) st.st_size )
+    return error("Object file truncated", 0, -1);
+  iMem = (INSTRUCTION *) (h + 1);
+  iMemSize = h->instCount;
+  dataInit = (TMOData *) (iMem + iMemSize);
+  dataCount = h->dataCount;
+  lineTab = (TMOLine *) (dataInit + dataCount);
+  lineCount = h->lineCount;
+  lineStr = (char *) (lineTab + lineCount);
+  /* no parsing, but never trust the operands */
+  for (loc = 0 ; loc < iMemSize ; loc++)
+  { if ( (iMem[loc].iop < 0) || (iMem[loc].iop >= opRALim)
+         || (strcmp(opCodeTab[iMem[loc].iop], "????") == 0) )
+      return error("Illegal opcode", 0, loc);
+    if ( (iMem[loc].iarg1 < 0) || (iMem[loc].iarg1 >= NO_REGS)
+         || (iMem[loc].iarg3 < 0) || (iMem[loc].iarg3 >= NO_REGS)
+         || ( (opClass(iMem[loc].iop) == opclRR)
+              && ((iMem[loc].iarg2 < 0) || (iMem[loc].iarg2 >= NO_REGS)) ) )
+      return error("Bad register", 0, loc);
+  }
+  for (loc = 0 ; loc < dataCount ; loc++)
+    if ( (dataInit[loc].addr < 0) || (dataInit[loc].addr >= dMemSize) )
+      return error("Bad data address", 0, -1);
+  for (loc = 0 ; loc < lineCount ; loc++)
+    if ( (lineTab[loc].str < 0) || (lineTab[loc].str >= h->strSize) )
+      return error("Bad comment offset", 0, -1);
+  if ( (h->strSize > 0) && (lineStr[h->strSize-1] != '\0') )
+    return error("Bad string section", 0, -1);
+  return TRUE;
+} /* loadObject */
+
 
 /********************************************/
 STEPRESULT stepTM (void)
@@ -311,7 +467,7 @@ STEPRESULT stepTM (void)
   int ok ;
 
   pc = reg[PC_REG] ;
-  if ( (pc < 0) || (pc > IADDR_SIZE)  )
+  if ( (unsigned) pc >= (unsigned) iMemSize )
       return srIMEM_ERR ;
   reg[PC_REG] = pc + 1 ;
   currentinstruction = iMem[ pc ] ;
@@ -328,7 +484,7 @@ STEPRESULT stepTM (void)
       r = currentinstruction.iarg1 ;
       s = currentinstruction.iarg3 ;
       m = currentinstruction.iarg2 + reg[s] ;
-      if ( (m < 0) || (m > DADDR_SIZE))
+      if ( (unsigned) m >= (unsigned) dMemSize )
          return srDMEM_ERR ;
       break;
 
@@ -396,13 +552,204 @@ STEPRESULT stepTM (void)
   return srOKAY ;
 } /* stepTM */
 
+/********************************************/
+void decodeInstructions (void)
+{ int loc, r, s, t, d, op;
+  DINSTRUCTION * di;
+  free(dCode) ;
+  dCode = malloc((iMemSize + 1) * sizeof(DINSTRUCTION)) ;
+  if ( dCode == NULL )
+  { printf("Out of memory for decoded instructions\n") ;
+    exit(1) ;
+  }
+  for (loc = 0 ; loc < iMemSize ; loc++)
+  { op = iMem[loc].iop ;
+    r = iMem[loc].iarg1 ;
+    s = iMem[loc].iarg2 ;
+    t = iMem[loc].iarg3 ;
+    di = &dCode[loc] ;
+    di->dop = dSTEP ;
+    di->r = r ; di->s = s ; di->t = t ; di->d = 0 ;
+    if ( opClass(op) == opclRR )
+    { if ( op == opHALT ) di->dop = dHALT ;
+      else if ( (op == opIN) || (op == opOUT) ) di->dop = dSTEP ;
+      else if ( (r != PC_REG) && (s != PC_REG) && (t != PC_REG) )
+        di->dop = dADD + (op - opADD) ;
+      continue ;
+    }
+    /* RM and RA: fold a pc-relative base into d */
+    d = s ;
+    s = t ;
+    if ( op == opLDC ) s = ZERO_REG ;
+    else if ( s == PC_REG )
+    { d += loc + 1 ;
+      s = ZERO_REG ;
+    }
+    di->d = d ; di->s = s ; di->t = 0 ;
+    switch ( op )
+    { case opLD :  di->dop = (r == PC_REG) ? dLDPC : dLD ; break;
+      case opST :  if ( r != PC_REG ) di->dop = dST ; break;
+      case opLDA :
+      case opLDC : di->dop = (r == PC_REG) ? dJMP : dLDA ; break;
+      default :    if ( r != PC_REG ) di->dop = dJLT + (op - opJLT) ; break;
+    }
+  }
+  dCode[iMemSize].dop = dIMEM ;
+  dCodeThreaded = FALSE ;
+} /* decodeInstructions */
+
+/********************************************/
+/* runTM executes the decoded instruction
+   stream from reg[PC_REG] until the program
+   stops, and returns the number of instructions
+   executed in *count */
+STEPRESULT runTM (int * count)
+{ DINSTRUCTION * ip ;
+  STEPRESULT result ;
+  int icount = 0 ;
+  int m ;
+  /* memory bases and bounds stay in locals: stores
+     through dMem cannot then force them to reload */
+  DINSTRUCTION * const code = dCode ;
+  int * const data = dMem ;
+  const unsigned isize = iMemSize ;
+  const unsigned dsize = dMemSize ;
+#if USE_COMPUTED_GOTO
+  static const void * labels[]
+        = { &&L_dHALT, &&L_dSTEP, &&L_dADD, &&L_dSUB, &&L_dMUL,
+            &&L_dDIV, &&L_dLD, &&L_dLDPC, &&L_dST, &&L_dLDA,
+            &&L_dJMP, &&L_dJLT, &&L_dJLE, &&L_dJGT, &&L_dJGE,
+            &&L_dJEQ, &&L_dJNE, &&L_dIMEM };
+  if ( ! dCodeThreaded )
+  { for (m = 0 ; m <= iMemSize ; m++)
+      dCode[m].handler = labels[dCode[m].dop] ;
+    dCodeThreaded = TRUE ;
+  }
+#define CASE(op)    L_##op
+#define DISPATCH()  do { icount++ ; goto *ip->handler ; } while (0)
+#else
+#define CASE(op)    case op
+#define DISPATCH()  do { icount++ ; goto dispatch ; } while (0)
+#endif
+/* NEXT falls through to the following instruction,
+   JUMP transfers control to an absolute location */
+#define NEXT()      do { ip++ ; DISPATCH() ; } while (0)
+#define JUMP(a)     do { m = (a) ; \
+                         if ( (unsigned) m >= isize ) \
+                         { icount++ ; reg[PC_REG] = m ; \
+                           result = srIMEM_ERR ; goto done ; } \
+                         ip = code + m ; DISPATCH() ; } while (0)
+#define FAULT(res)  do { reg[PC_REG] = ip - code + 1 ; \
+                         result = (res) ; goto done ; } while (0)
+
+  JUMP(reg[PC_REG]) ;
+#if ! USE_COMPUTED_GOTO
+dispatch:
+  switch ( ip->dop )
+#endif
+  {
+    CASE(dHALT) :
+      reg[PC_REG] = ip - code + 1 ;
+      printf("HALT: %1d,%1d,%1d\n",ip->r,ip->s,ip->t);
+      result = srHALT ;
+      goto done ;
+
+    CASE(dSTEP) :
+      /* uncommon instruction: let stepTM do it */
+      reg[PC_REG] = ip - code ;
+      result = stepTM () ;
+      if ( result != srOKAY ) goto done ;
+      JUMP(reg[PC_REG]) ;
+
+    CASE(dADD) :  reg[ip->r] = reg[ip->s] + reg[ip->t] ;  NEXT();
+    CASE(dSUB) :  reg[ip->r] = reg[ip->s] - reg[ip->t] ;  NEXT();
+    CASE(dMUL) :  reg[ip->r] = reg[ip->s] * reg[ip->t] ;  NEXT();
+
+    CASE(dDIV) :
+      if ( reg[ip->t] == 0 ) FAULT(srZERODIVIDE) ;
+      reg[ip->r] = reg[ip->s] / reg[ip->t] ;
+      NEXT();
+
+    CASE(dLD) :
+      m = ip->d + reg[ip->s] ;
+      if ( (unsigned) m >= dsize ) FAULT(srDMEM_ERR) ;
+      reg[ip->r] = data[m] ;
+      NEXT();
+
+    CASE(dLDPC) :
+      m = ip->d + reg[ip->s] ;
+      if ( (unsigned) m >= dsize ) FAULT(srDMEM_ERR) ;
+      JUMP(data[m]) ;
+
+    CASE(dST) :
+      m = ip->d + reg[ip->s] ;
+      if ( (unsigned) m >= dsize ) FAULT(srDMEM_ERR) ;
+      data[m] = reg[ip->r] ;
+      NEXT();
+
+    CASE(dLDA) :  reg[ip->r] = ip->d + reg[ip->s] ;  NEXT();
+    CASE(dJMP) :  JUMP(ip->d + reg[ip->s]) ;
+
+    CASE(dJLT) :  if ( reg[ip->r] <  0 ) JUMP(ip->d + reg[ip->s]) ; NEXT();
+    CASE(dJLE) :  if ( reg[ip->r] <= 0 ) JUMP(ip->d + reg[ip->s]) ; NEXT();
+    CASE(dJGT) :  if ( reg[ip->r] >  0 ) JUMP(ip->d + reg[ip->s]) ; NEXT();
+    CASE(dJGE) :  if ( reg[ip->r] >= 0 ) JUMP(ip->d + reg[ip->s]) ; NEXT();
+    CASE(dJEQ) :  if ( reg[ip->r] == 0 ) JUMP(ip->d + reg[ip->s]) ; NEXT();
+    CASE(dJNE) :  if ( reg[ip->r] != 0 ) JUMP(ip->d + reg[ip->s]) ; NEXT();
+
+    CASE(dIMEM) :
+      reg[PC_REG] = isize ;
+      result = srIMEM_ERR ;
+      goto done ;
+  }
+done:
+  *count = icount ;
+  return result ;
+#undef CASE
+#undef DISPATCH
+#undef NEXT
+#undef JUMP
+#undef FAULT
+} /* runTM */
+
+
+/********************************************/
+/* benchTM runs the program to completion with
+   the single-step loop and with the decoded
+   engine, and reports instructions per second */
+void benchTM (void)
+{ int engine, stepcnt;
+  STEPRESULT stepResult;
+  clock_t start;
+  double secs;
+  for (engine = 0 ; engine < 2 ; engine++)
+  { resetTM();
+    start = clock();
+    if ( engine == 0 )
+    { stepcnt = 0;
+      stepResult = srOKAY;
+      while (stepResult == srOKAY)
+      { stepResult = stepTM ();
+        stepcnt++;
+      }
+    }
+    else stepResult = runTM (&stepcnt);
+    secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+    printf("%-8s %s: %d instructions in %.3f s",
+           engine == 0 ? "step" : "decoded",
+           stepResultTab[stepResult], stepcnt, secs);
+    if ( secs > 0 ) printf(" (%.0f instructions/s)", stepcnt / secs);
+    printf("\n");
+  }
+  resetTM();
+} /* benchTM */
+
 /********************************************/
 int doCommand (void)
 { char cmd;
   int stepcnt=0, i;
   int printcnt;
   int stepResult;
-  int regNo, loc;
   do
   { printf ("Enter command: ");
     fflush (stdin);
@@ -440,6 +787,8 @@ int doCommand (void)
       printf("   p(rint         "\
              "Toggle print of total instructions executed"\
              " ('go' only)\n");
+      printf("   b(ench         "\
+             "Time 'go' with the step loop and the decoded engine\n");
       printf("   c(lear         "\
              "Reset simulator for new execution of program\n");
       printf("   h(elp          "\
@@ -464,6 +813,8 @@ int doCommand (void)
 
     case 'g' :   stepcnt = 1 ;     break;
 
+    case 'b' :   benchTM () ;      break;
+
     case 'r' :
     /***********************************/
       for (i = 0; i < NO_REGS; i++)
@@ -482,7 +833,7 @@ int doCommand (void)
       if ( ! atEOL ())
         printf ("Instruction locations?\n");
       else
-      { while ((iloc >= 0) && (iloc < IADDR_SIZE)
+      { while ((iloc >= 0) && (iloc < iMemSize)
                 && (printcnt > 0) )
         { writeInstruction(iloc);
           iloc++ ;
@@ -501,7 +852,7 @@ int doCommand (void)
       if ( ! atEOL ())
         printf("Data locations?\n");
       else
-      { while ((dloc >= 0) && (dloc < DADDR_SIZE)
+      { while ((dloc >= 0) && (dloc < dMemSize)
                   && (printcnt > 0))
         { printf("%5d: %5d\n",dloc,dMem[dloc]);
           dloc++;
@@ -515,11 +866,7 @@ int doCommand (void)
       iloc = 0;
       dloc = 0;
       stepcnt = 0;
-      for (regNo = 0;  regNo < NO_REGS ; regNo++)
-            reg[regNo] = 0 ;
-      dMem[0] = DADDR_SIZE - 1 ;
-      for (loc = 1 ; loc < DADDR_SIZE ; loc++)
-            dMem[loc] = 0 ;
+      resetTM();
       break;
 
     case 'q' : return FALSE;  /* break; */
@@ -530,12 +877,15 @@ int doCommand (void)
   if ( stepcnt > 0 )
   { if ( cmd == 'g' )
     { stepcnt = 0;
-      while (stepResult == srOKAY)
-      { iloc = reg[PC_REG] ;
-        if ( traceflag ) writeInstruction( iloc ) ;
-        stepResult = stepTM ();
-        stepcnt++;
+      if ( traceflag )
+      { while (stepResult == srOKAY)
+        { iloc = reg[PC_REG] ;
+          writeInstruction( iloc ) ;
+          stepResult = stepTM ();
+          stepcnt++;
+        }
       }
+      else stepResult = runTM (&stepcnt);
       if ( icountflag )
         printf("Number of instructions executed = %d\n",stepcnt);
     }
@@ -558,11 +908,32 @@ int doCommand (void)
 /********************************************/
 
 main( int argc, char * argv[] )
-{ if (argc != 2)
-  { printf("usage: %s <filename>\n",argv[0]);
+{ char magic[4];
+  int isObject;
+  int argi = 1;
+  /* -i and -d set the iMem limit and the dMem size */
+  while ( (argi + 2 < argc) && (argv[argi][0] == '-') )
+  { if ( strcmp(argv[argi], "-i") == 0 )
+      iMemMax = atoi(argv[argi+1]) ;
+    else if ( strcmp(argv[argi], "-d") == 0 )
+      dMemSize = atoi(argv[argi+1]) ;
+    else break ;
+    argi += 2 ;
+  }
+  if ( (argi != argc - 1) || (iMemMax < 0) || (dMemSize < 1) )
+  { printf("usage: %s [-i isize] [-d dsize] <filename>\n",argv[0]);
     exit(1);
   }
-  strcpy(pgmName,argv[1]) ;
+  dMem = malloc(dMemSize * sizeof(int)) ;
+  if ( dMem == NULL )
+  { printf("Cannot allocate %d dMem locations\n",dMemSize);
+    exit(1);
+  }
+  if ( strlen(argv[argi]) + 4 > sizeof(pgmName) )
+  { printf("file name '%s' too long\n",argv[argi]);
+    exit(1);
+  }
+  strcpy(pgmName,argv[argi]) ;
   if (strchr (pgmName, '.') == NULL)
      strcat(pgmName,".tm");
   pgm = fopen(pgmName,"r");
@@ -571,9 +942,22 @@ main( int argc, char * argv[] )
     exit(1);
   }
 
-  /* read the program */
-  if ( ! readInstructions ())
+  /* read the program: binary objects are mapped,
+     text programs are parsed */
+  isObject = (fread(magic, 1, 4, pgm) == 4)
+             && (memcmp(magic, TMO_MAGIC, 4) == 0);
+  if ( isObject )
+  { fclose(pgm);
+    if ( ! loadObject (pgmName))
          exit(1) ;
+    resetTM ();
+  }
+  else
+  { rewind(pgm);
+    if ( ! readInstructions ())
+         exit(1) ;
+  }
+  decodeInstructions ();
   /* switch input file to terminal */
   /* reset( input ); */
   /* read-eval-print */
@@ -0,0 +1,78 @@
+/****************************************************/
+/* File: tmo.h                                      */
+/* Binary object format for the TM machine          */
+/* (written by code.c, loaded by tm.c with mmap)    */
+/****************************************************/
+
+#ifndef _TMO_H_
+#define _TMO_H_
+
+/* magic number at the start of every object file,
+ * text programs never start with it
+ */
+#define TMO_MAGIC "TMO1"
+#define TMO_VERSION 1
+
+/* TMO_OPCODES is the opcode name table; the opcode
+ * number stored in an object file is the index of
+ * its name in this table (the OPCODE enum of tm.c)
+ */
+#define TMO_OPCODES \
+  { "HALT", "IN", "OUT", "ADD", "SUB", "MUL", "DIV", "????", \
+    "LD", "ST", "????", \
+    "LDA", "LDC", "JLT", "JLE", "JGT", "JGE", "JEQ", "JNE", "????" }
+#define TMO_NOPCODES 20
+
+/* opcode numbers, in the order of TMO_OPCODES */
+typedef enum
+{
+  tmoHALT, tmoIN, tmoOUT, tmoADD, tmoSUB, tmoMUL, tmoDIV,
+  tmoRRLim, /* register-only opcodes come before this */
+  tmoLD, tmoST,
+  tmoRMLim, /* register-memory opcodes come before this */
+  tmoLDA, tmoLDC, tmoJLT, tmoJLE, tmoJGT, tmoJGE, tmoJEQ, tmoJNE,
+  tmoRALim
+} TMOOpcode;
+
+/* An object file is laid out as
+ *   TMOHeader header;
+ *   TMOInst   inst[instCount];   code, one per location
+ *   TMOData   data[dataCount];   initial dMem contents
+ *   TMOLine   line[lineCount];   comments, sorted by loc
+ *   char      strings[strSize];  comment text
+ * all integers are in host byte order
+ */
+typedef struct
+{
+  char magic[4];
+  int version;
+  int byteOrder; /* 1 when written on this host */
+  int instSize;  /* sizeof(TMOInst) */
+  int instCount;
+  int dataCount;
+  int lineCount;
+  int strSize;
+} TMOHeader;
+
+/* same layout as INSTRUCTION in tm.c */
+typedef struct
+{
+  int iop;
+  int iarg1;
+  int iarg2;
+  int iarg3;
+} TMOInst;
+
+typedef struct
+{
+  int addr;
+  int value;
+} TMOData;
+
+typedef struct
+{
+  int loc; /* instruction the comment belongs to */
+  int str; /* offset of the comment in strings */
+} TMOLine;
+
+#endif
@@ -6,13 +6,16 @@
 /* Kenneth C. Louden                                */
 /****************************************************/
 
+#include <limits.h>
 #include "globals.h"
 #include "util.h"
+#include "arena.h"
+#include "intern.h"
 
 /* Procedure printToken prints a token 
  * and its lexeme to the listing file
  */
-void printToken( TokenType token, const char* tokenString )
+void printToken( Compiler cc, TokenType token, const char* tokenString )
 { switch (token)
   { // case INT:
     // case VOID:
@@ -29,59 +32,59 @@ void printToken( TokenType token, const char* tokenString )
     case RETURN:
     case INT:
     case VOID:
-      fprintf(listing,"reserved word: %s\n",tokenString);
+      fprintf(cc->listing,"reserved word: %s\n",tokenString);
       break;
-    case ASSIGN: fprintf(listing,"=\n"); break;
-    case EQ: fprintf(listing,"==\n"); break;
-    case NE: fprintf(listing,"!=\n"); break;
-    case LT: fprintf(listing,"<\n"); break;
-    case LE: fprintf(listing,"<=\n"); break;
-    case GT: fprintf(listing,">\n"); break;
-    case GE: fprintf(listing,">=\n"); break;
-    case LPAREN: fprintf(listing,"(\n"); break;
-    case RPAREN: fprintf(listing,")\n"); break;
-    case LBRACE: fprintf(listing,"[\n"); break;
-    case RBRACE: fprintf(listing,"]\n"); break;
-    case LCURLY: fprintf(listing,"{\n"); break;
-    case RCURLY: fprintf(listing,"}\n"); break;
-    case SEMI: fprintf(listing,";\n"); break;
-    case COMMA: fprintf(listing,",\n"); break;
-    case PLUS: fprintf(listing,"+\n"); break;
-    case MINUS: fprintf(listing,"-\n"); break;
-    case TIMES: fprintf(listing,"*\n"); break;
-    case OVER: fprintf(listing,"/\n"); break;
-    case ENDFILE: fprintf(listing,"EOF\n"); break;
+    case ASSIGN: fprintf(cc->listing,"=\n"); break;
+    case EQ: fprintf(cc->listing,"==\n"); break;
+    case NE: fprintf(cc->listing,"!=\n"); break;
+    case LT: fprintf(cc->listing,"<\n"); break;
+    case LE: fprintf(cc->listing,"<=\n"); break;
+    case GT: fprintf(cc->listing,">\n"); break;
+    case GE: fprintf(cc->listing,">=\n"); break;
+    case LPAREN: fprintf(cc->listing,"(\n"); break;
+    case RPAREN: fprintf(cc->listing,")\n"); break;
+    case LBRACE: fprintf(cc->listing,"[\n"); break;
+    case RBRACE: fprintf(cc->listing,"]\n"); break;
+    case LCURLY: fprintf(cc->listing,"{\n"); break;
+    case RCURLY: fprintf(cc->listing,"}\n"); break;
+    case SEMI: fprintf(cc->listing,";\n"); break;
+    case COMMA: fprintf(cc->listing,",\n"); break;
+    case PLUS: fprintf(cc->listing,"+\n"); break;
+    case MINUS: fprintf(cc->listing,"-\n"); break;
+    case TIMES: fprintf(cc->listing,"*\n"); break;
+    case OVER: fprintf(cc->listing,"/\n"); break;
+    case ENDFILE: fprintf(cc->listing,"EOF\n"); break;
     case NUM:
-      fprintf(listing,
+      fprintf(cc->listing,
           "NUM, val= %s\n",tokenString);
       break;
     case ID:
-      fprintf(listing,
+      fprintf(cc->listing,
           "ID, name= %s\n",tokenString);
       break;
     case ERROR:
-      fprintf(listing,
+      fprintf(cc->listing,
           "ERROR: %s\n",tokenString);
       break;
     default: /* should never happen */
-      fprintf(listing,"Unknown token: %d\n",token);
+      fprintf(cc->listing,"Unknown token: %d\n",token);
   }
 }
 
 /* Function newStmtNode creates a new statement
  * node for syntax tree construction
  */
-TreeNode * newStmtNode(StmtKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+TreeNode * newStmtNode(Compiler cc, StmtKind kind)
+{ TreeNode * t = (TreeNode *) arenaAlloc(cc,sizeof(TreeNode),ArenaNode);
   int i;
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    fprintf(cc->listing,"Out of memory error at line %d\n",cc->lineno);
   else {
     for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
     t->sibling = NULL;
     t->nodekind = StmtK;
     t->kind.stmt = kind;
-    t->lineno = lineno;
+    t->lineno = cc->lineno;
   }
   return t;
 }
@@ -89,17 +92,17 @@ TreeNode * newStmtNode(StmtKind kind)
 /* Function newExpNode creates a new expression 
  * node for syntax tree construction
  */
-TreeNode * newExpNode(ExpKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+TreeNode * newExpNode(Compiler cc, ExpKind kind)
+{ TreeNode * t = (TreeNode *) arenaAlloc(cc,sizeof(TreeNode),ArenaNode);
   int i;
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    fprintf(cc->listing,"Out of memory error at line %d\n",cc->lineno);
   else
   { for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
     t->sibling = NULL;
     t->nodekind = ExpK;
     t->kind.exp = kind;
-    t->lineno = lineno;
+    t->lineno = cc->lineno;
     t->type = Void;
   }
   return t;
@@ -108,17 +111,17 @@ TreeNode * newExpNode(ExpKind kind)
 /* Function newExpNode creates a new expression 
  * node for syntax tree construction
  */
-TreeNode * newDeclNode(DeclKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+TreeNode * newDeclNode(Compiler cc, DeclKind kind)
+{ TreeNode * t = (TreeNode *) arenaAlloc(cc,sizeof(TreeNode),ArenaNode);
   int i;
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    fprintf(cc->listing,"Out of memory error at line %d\n",cc->lineno);
   else
   { for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
     t->sibling = NULL;
     t->nodekind = DeclK;
     t->kind.decl = kind;
-    t->lineno = lineno;
+    t->lineno = cc->lineno;
   }
   return t;
 }
@@ -126,17 +129,17 @@ TreeNode * newDeclNode(DeclKind kind)
 /* Function newExpNode creates a new expression 
  * node for syntax tree construction
  */
-TreeNode * newParamNode(ParamKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+TreeNode * newParamNode(Compiler cc, ParamKind kind)
+{ TreeNode * t = (TreeNode *) arenaAlloc(cc,sizeof(TreeNode),ArenaNode);
   int i;
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    fprintf(cc->listing,"Out of memory error at line %d\n",cc->lineno);
   else
   {  for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
     t->sibling = NULL;
     t->nodekind = ParamK;
     t->kind.param = kind;
-    t->lineno = lineno;
+    t->lineno = cc->lineno;
   }
   return t;
 }
@@ -144,160 +147,253 @@ TreeNode * newParamNode(ParamKind kind)
 /* Function newExpNode creates a new expression 
  * node for syntax tree construction
  */
-TreeNode * newTypeNode(TypeKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+TreeNode * newTypeNode(Compiler cc, TypeKind kind)
+{ TreeNode * t = (TreeNode *) arenaAlloc(cc,sizeof(TreeNode),ArenaNode);
   int i;
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    fprintf(cc->listing,"Out of memory error at line %d\n",cc->lineno);
   else
   { for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
     t->sibling = NULL;
     t->nodekind = TypeK;
     t->kind.type = kind;
-    t->lineno = lineno;
+    t->lineno = cc->lineno;
   }
   return t;
 }
 
 /* Function copyString allocates and makes a new
- * copy of an existing string
+ * copy of an existing string in the arena
  */
-char * copyString(char * s)
+char * copyString(Compiler cc, char * s)
 { int n;
   char * t;
   if (s==NULL) return NULL;
   n = strlen(s)+1;
-  t = malloc(n);
+  t = arenaAlloc(cc,n,ArenaString);
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    fprintf(cc->listing,"Out of memory error at line %d\n",cc->lineno);
   else strcpy(t,s);
   return t;
 }
 
-/* Variable indentno is used by printTree to
- * store current number of spaces to indent
+/* Function lexemeString copies the lexeme of the
+ * current token to tokenString, truncated to
+ * MAXTOKENLEN chars, for the listing
  */
-static indentno = 0;
+char * lexemeString(Compiler cc)
+{ int n = cc->lexemeLength < MAXTOKENLEN ? cc->lexemeLength : MAXTOKENLEN;
+  if (n > 0) memcpy(cc->tokenString,cc->lexeme,n);
+  cc->tokenString[n] = '\0';
+  return cc->tokenString;
+}
 
-/* macros to increase/decrease indentation */
-#define INDENT indentno+=2
-#define UNINDENT indentno-=2
+/* Function lexemeName returns the interned
+ * lexeme of the current token, at full length
+ */
+char * lexemeName(Compiler cc)
+{ if (cc->tokenAttr) return cc->tokenName;
+  return internSpan(cc,cc->lexeme,cc->lexemeLength);
+}
+
+/* Function lexemeNumber returns the value of the
+ * lexeme of the current NUM token, as atoi would
+ */
+int lexemeNumber(Compiler cc)
+{ long v = 0;
+  int i, d;
+  if (cc->tokenAttr) return cc->tokenValue;
+  for (i = 0; i < cc->lexemeLength; i++)
+  { d = cc->lexeme[i] - '0';
+    if (v > (LONG_MAX - d) / 10)
+    { v = LONG_MAX;
+      break;
+    }
+    v = v * 10 + d;
+  }
+  return (int) v;
+}
+
+/* a node being traversed and the index of
+   the next child to visit */
+typedef struct
+{ TreeNode * t;
+  int child;
+} TraverseFrame;
+
+/* Procedure traverse is a generic syntax tree
+ * traversal routine: it applies preProc in
+ * preorder and postProc in postorder to the tree
+ * pointed to by t and its siblings; a sibling
+ * replaces the frame of the node before it, so
+ * the stack grows only with the nesting depth
+ */
+void traverse( Compiler cc, TreeNode * t,
+               void (* preProc) (Compiler, TreeNode *),
+               void (* postProc) (Compiler, TreeNode *) )
+{ TraverseFrame * stack = NULL;
+  int top = 0, max = 0;
+  TreeNode * c;
+  if (t == NULL) return;
+  while (TRUE)
+  { if (t != NULL)
+    { /* enter t */
+      if (top == max)
+      { max = max ? 2*max : 256;
+        stack = realloc(stack,max*sizeof(TraverseFrame));
+        if (stack == NULL)
+        { fprintf(cc->listing,"Out of memory error at line %d\n",cc->lineno);
+          exit(1);
+        }
+      }
+      preProc(cc,t);
+      stack[top].t = t;
+      stack[top].child = 0;
+      top++;
+    }
+    if (top == 0) break;
+    if (stack[top-1].child < MAXCHILDREN)
+    { t = stack[top-1].t->child[stack[top-1].child++];
+      continue;
+    }
+    /* leave the node and move on to its sibling */
+    c = stack[--top].t;
+    postProc(cc,c);
+    t = c->sibling;
+  }
+  free(stack);
+}
+
+/* macros to increase/decrease indentation;
+ * printTree keeps the current number of spaces
+ * to indent in cc->indentno
+ */
+#define INDENT cc->indentno+=2
+#define UNINDENT cc->indentno-=2
 
 /* printSpaces indents by printing spaces */
-static void printSpaces(void)
+static void printSpaces( Compiler cc )
 { int i;
-  for (i=0;i<indentno;i++)
-    fprintf(listing," ");
+  for (i=0;i<cc->indentno;i++)
+    fprintf(cc->listing," ");
 }
 
-/* procedure printTree prints a syntax tree to the 
- * listing file using indentation to indicate subtrees
+/* printNode prints tree at the current
+ * indentation and indents its children
  */
-void printTree( TreeNode * tree )
-{ int i;
-  INDENT;
-  while (tree != NULL)
-  { if (tree->nodekind!=TypeK)
-      printSpaces();
-    if (tree->nodekind==StmtK)
-    { switch (tree->kind.stmt) {
-        case CompK:
-          fprintf(listing,"Compound statement :\n");
-          break;
-        case IfK:
-          fprintf(listing,"If (condition) (body)\n");
-          break;
-        case IfEK:
-          fprintf(listing,"If (condition) (body) (else)\n");
-          break;
-        case IterK:
-          fprintf(listing,"Repeat : \n");
-          break;
-        case RetK:
-          fprintf(listing,"Return : \n");
-          break;
-        default:
-          fprintf(listing,"Unknown ExpNode kind\n");
-          break;
-      }
+static void printNode( Compiler cc, TreeNode * tree )
+{ if (tree->nodekind!=TypeK)
+    printSpaces(cc);
+  if (tree->nodekind==StmtK)
+  { switch (tree->kind.stmt) {
+      case CompK:
+        fprintf(cc->listing,"Compound statement :\n");
+        break;
+      case IfK:
+        fprintf(cc->listing,"If (condition) (body)\n");
+        break;
+      case IfEK:
+        fprintf(cc->listing,"If (condition) (body) (else)\n");
+        break;
+      case IterK:
+        fprintf(cc->listing,"Repeat : \n");
+        break;
+      case RetK:
+        fprintf(cc->listing,"Return : \n");
+        break;
+      default:
+        fprintf(cc->listing,"Unknown ExpNode kind\n");
+        break;
     }
-    else if (tree->nodekind==ExpK)
-    { switch (tree->kind.exp) {
-        case AssignK:
-          fprintf(listing,"Assign : (destination) (source)\n");
-          break;
-        case OpK:
-          fprintf(listing,"Op : ");
-          printToken(tree->attr.op,"\0");
-          break;
-        case ConstK:
-          fprintf(listing,"Const : %d\n",tree->attr.val);
-          break;
-        case IdK:
-          fprintf(listing,"Id : %s\n",tree->attr.name);
-          break;
-        case ArrIdK:
-          fprintf(listing,"ArrId : %s\n",tree->attr.name);
-          break;
-        case CallK:
-          fprintf(listing,"Call, name : %s, with arguments below\n",tree->attr.name);
-          break;
-        default:
-          fprintf(listing,"Unknown ExpNode kind\n");
-          break;
-      }
+  }
+  else if (tree->nodekind==ExpK)
+  { switch (tree->kind.exp) {
+      case AssignK:
+        fprintf(cc->listing,"Assign : (destination) (source)\n");
+        break;
+      case OpK:
+        fprintf(cc->listing,"Op : ");
+        printToken(cc,tree->attr.op,"\0");
+        break;
+      case ConstK:
+        fprintf(cc->listing,"Const : %d\n",tree->attr.val);
+        break;
+      case IdK:
+        fprintf(cc->listing,"Id : %s\n",tree->attr.name);
+        break;
+      case ArrIdK:
+        fprintf(cc->listing,"ArrId : %s\n",tree->attr.name);
+        break;
+      case CallK:
+        fprintf(cc->listing,"Call, name : %s, with arguments below\n",tree->attr.name);
+        break;
+      default:
+        fprintf(cc->listing,"Unknown ExpNode kind\n");
+        break;
     }
-    else if (tree->nodekind==DeclK)
-    { switch (tree->kind.decl) {
-        case FuncK:
-          fprintf(listing,"Function declaration, name : %s, return ",tree->attr.name);
-          break;
-        case VarK:
-          fprintf(listing,"Var declaration, name : %s, ",tree->attr.name);
-          break;
-        case ArrVarK:
-          fprintf(listing,"Arr Var declaration, name : %s, size : %d, ",tree->attr.arr.name,tree->attr.arr.size);
-          break;
-        default:
-          fprintf(listing,"Unknown DeclNode kind\n");
-          break;
-      }
+  }
+  else if (tree->nodekind==DeclK)
+  { switch (tree->kind.decl) {
+      case FuncK:
+        fprintf(cc->listing,"Function declaration, name : %s, return ",tree->attr.name);
+        break;
+      case VarK:
+        fprintf(cc->listing,"Var declaration, name : %s, ",tree->attr.name);
+        break;
+      case ArrVarK:
+        fprintf(cc->listing,"Arr Var declaration, name : %s, size : %d, ",tree->attr.arr.name,tree->attr.arr.size);
+        break;
+      default:
+        fprintf(cc->listing,"Unknown DeclNode kind\n");
+        break;
     }
-    else if (tree->nodekind==ParamK)
-    { switch (tree->kind.param) {
-        case ArrParamK:
-          fprintf(listing,"Array parameter, name : %s, ",tree->attr.name);
-          break;
-        case NonArrParamK:
-          fprintf(listing,"Single parameter, name : %s, ",tree->attr.name);
-          break;
-        default:
-          fprintf(listing,"Unknown ParamNode kind\n");
-          break;
-      }
+  }
+  else if (tree->nodekind==ParamK)
+  { switch (tree->kind.param) {
+      case ArrParamK:
+        fprintf(cc->listing,"Array parameter, name : %s, ",tree->attr.name);
+        break;
+      case NonArrParamK:
+        fprintf(cc->listing,"Single parameter, name : %s, ",tree->attr.name);
+        break;
+      default:
+        fprintf(cc->listing,"Unknown ParamNode kind\n");
+        break;
     }
-    else if (tree->nodekind==TypeK)
-    { switch (tree->kind.type) {
-        case TypeNameK:
-          fprintf(listing,"type : ");
-          switch (tree->attr.type) {
-            case INT:
-              fprintf(listing,"int\n");
-              break;
-            case VOID:
-              fprintf(listing,"void\n");
-              break;
-          }
-          break;
-        default:
-          fprintf(listing,"Unknown TypeNode kind\n");
-          break;
-      }
+  }
+  else if (tree->nodekind==TypeK)
+  { switch (tree->kind.type) {
+      case TypeNameK:
+        fprintf(cc->listing,"type : ");
+        switch (tree->attr.type) {
+          case INT:
+            fprintf(cc->listing,"int\n");
+            break;
+          case VOID:
+            fprintf(cc->listing,"void\n");
+            break;
+        }
+        break;
+      default:
+        fprintf(cc->listing,"Unknown TypeNode kind\n");
+        break;
     }
-    else fprintf(listing,"Unknown node kind\n");
-    for (i=0;i<MAXCHILDREN;i++)
-         printTree(tree->child[i]);
-    tree = tree->sibling;
   }
+  else fprintf(cc->listing,"Unknown node kind\n");
+  INDENT;
+}
+
+/* unindent ends the children of a node */
+static void unindent( Compiler cc, TreeNode * tree )
+{ (void) tree;
+  UNINDENT;
+}
+
+/* procedure printTree prints a syntax tree to the 
+ * listing file using indentation to indicate subtrees
+ */
+void printTree( Compiler cc, TreeNode * tree )
+{ INDENT;
+  traverse(cc,tree,printNode,unindent);
   UNINDENT;
 }
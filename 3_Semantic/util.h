@@ -11,26 +11,68 @@
 /* Procedure printToken prints a token 
  * and its lexeme to the listing file
  */
-void printToken( TokenType, const char* );
+void printToken( Compiler, TokenType, const char* );
 
 /* Function newStmtNode creates a new statement
  * node for syntax tree construction
  */
-TreeNode * newStmtNode(StmtKind);
+TreeNode * newStmtNode(Compiler, StmtKind);
 
 /* Function newExpNode creates a new expression 
  * node for syntax tree construction
  */
-TreeNode * newExpNode(ExpKind);
+TreeNode * newExpNode(Compiler, ExpKind);
+
+/* Function newDeclNode creates a new declaration
+ * node for syntax tree construction
+ */
+TreeNode * newDeclNode(Compiler, DeclKind);
+
+/* Function newParamNode creates a new parameter
+ * node for syntax tree construction
+ */
+TreeNode * newParamNode(Compiler, ParamKind);
+
+/* Function newTypeNode creates a new type
+ * node for syntax tree construction
+ */
+TreeNode * newTypeNode(Compiler, TypeKind);
 
 /* Function copyString allocates and makes a new
- * copy of an existing string
+ * copy of an existing string in the arena
+ */
+char * copyString( Compiler, char * );
+
+/* Function lexemeString copies the lexeme of the
+ * current token to cc->tokenString for the
+ * listing, truncated to MAXTOKENLEN chars
+ */
+char * lexemeString( Compiler );
+
+/* Function lexemeName returns the interned
+ * lexeme of the current token
+ */
+char * lexemeName( Compiler );
+
+/* Function lexemeNumber returns the value of
+ * the lexeme of the current NUM token
+ */
+int lexemeNumber( Compiler );
+
+/* Procedure traverse is a generic syntax tree
+ * traversal routine: it applies preProc in
+ * preorder and postProc in postorder to the tree
+ * pointed to by t and its siblings; it keeps its
+ * own stack, so the depth of the tree and the
+ * length of sibling lists are limited by memory
  */
-char * copyString( char * );
+void traverse( Compiler cc, TreeNode * t,
+               void (* preProc) (Compiler, TreeNode *),
+               void (* postProc) (Compiler, TreeNode *) );
 
 /* procedure printTree prints a syntax tree to the 
  * listing file using indentation to indicate subtrees
  */
-void printTree( TreeNode * );
+void printTree( Compiler, TreeNode * );
 
 #endif